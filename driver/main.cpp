@@ -10,12 +10,34 @@
 	#include "tests/jobqueue/jobqueuetest.h"
 	#include "tests/bitstream/bitstreamtest.h"
 	#include "tests/atomicset/atomicsettest.h"
+	#include "tests/ringbuffer/ringbuffertest.h"
+	#include "tests/outboundqueue/outboundqueuetest.h"
+	#include "tests/compression/compressiontest.h"
+	#include "tests/packetwriter/packetwritertest.h"
+	#include "tests/packetschema/packetschematest.h"
+	#include "tests/varintbatch/varintbatchtest.h"
+	#include "tests/utf8/utf8test.h"
+	#include "tests/job/jobtest.h"
+	#include "tests/threadpool/threadpooltest.h"
+	#include "tests/tickmetrics/tickmetricstest.h"
+	#include "tests/async/asynctest.h"
 
 	// Comment any of these definitions to run that test
 //	#define VarNumTest()
 	#define JobQueueTest()
 	#define BitStreamTest()
 	#define AtomicSetTest()
+	#define RingBufferTest()
+	#define OutboundQueueTest()
+	#define CompressionTest()
+	#define PacketWriterTest()
+	#define PacketSchemaTest()
+	#define VarIntBatchTest()
+	#define Utf8Test()
+	#define JobTest()
+	#define ThreadPoolTest()
+	#define TickMetricsTest()
+	#define AsyncTest()
 
 	// Runs all of the tests to make sure that certain code works
 	void RunTests()
@@ -32,6 +54,39 @@
 		// Test the AtomicSet
 		AtomicSetTest();
 
+		// Test the RingBuffer
+		RingBufferTest();
+
+		// Test the OutboundQueue
+		OutboundQueueTest();
+
+		// Test the compression
+		CompressionTest();
+
+		// Test the PacketWriter
+		PacketWriterTest();
+
+		// Test the PacketSchemas
+		PacketSchemaTest();
+
+		// Test the bulk VarInt encoder and decoder
+		VarIntBatchTest();
+
+		// Test the UTF-8 validator and string views
+		Utf8Test();
+
+		// Test the move-only jobs
+		JobTest();
+
+		// Test the work-stealing thread pool
+		ThreadPoolTest();
+
+		// Test the tick timing metrics
+		TickMetricsTest();
+
+		// Test the coroutines
+		AsyncTest();
+
 		// Wait for the user to press enter before exiting
 		system("pause");
 		exit(0);
@@ -40,11 +95,17 @@
 	#define RunTests()
 #endif
 
-class Game : public EventHandler
+class Game : public BasicEventHandler<Game>
 {
+	friend class EventHandler;
 private:
+	/* The game's own events replace EventHandler's, and are called without any virtual calls */
+	void chatMessage(ChatMessageEventArgs e)
+	{
+		EventHandler::chatMessage(e);
+	}
 public:
-	Game() : EventHandler() {}
+	Game() : BasicEventHandler<Game>() {}
 };
 
 
@@ -54,8 +115,7 @@ int main()
 	RunTests();
 
 	// Create the server and its handlers then start the server
-//	Game game();
-	EventHandler* game = new EventHandler();
+	Game* game = new Game();
 	NetworkHandler* networkHandler = new NetworkHandler(game);
 	Server server = Server(game, networkHandler);
 	server.start();
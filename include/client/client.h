@@ -3,10 +3,13 @@
 #include "data/datatypes.h"
 #include "data/atomicset.h"
 #include "data/jobqueue.h"
+#include "data/ringbuffer.h"
+#include "data/outboundqueue.h"
 #include "client/clientevents.h"
 #include "server/serverevents.h"
 #include <utility>
 #include <set>
+#include <deque>
 
 #ifdef _WIN32 // WINDOWS
 	#ifndef WIN32_LEAN_AND_MEAN
@@ -17,12 +20,28 @@
 	#pragma comment(lib, "Ws2_32.lib")
 #else		  // LINUX, POSIX, OSX
 	#include <sys/socket.h>
-	#include <arpa/net.h>
+	#include <arpa/inet.h>
 	#include <netdb.h>
 	#include <unistd.h>
+	#include <errno.h>
 	typedef int SOCKET;
+	#define INVALID_SOCKET (-1)
+	#define SOCKET_ERROR (-1)
+	#define SD_BOTH SHUT_RDWR
+	#define WSAGetLastError() errno
 #endif
 
+struct NetworkThread;
+
+// A chunk waiting for its turn to be sent, or held back because the client had too much left to receive
+struct DeferredChunk
+{
+	Int x;
+	Int z;
+	Boolean createChunk;
+	Boolean inOverworld;
+};
+
 class Client
 {
 protected:
@@ -39,6 +58,8 @@ protected:
 	DisplayedSkinParts skinParts;				   // Which skin parts are visible on the player model
 	PlayerAbilities abilities;					   // Whether the client is creative, vulnerable, flying, etc.
 	Int ticksSinceUpdate;						   // How many ticks it's been since a ping
+	Int ticksCongested;							   // How many ticks in a row the client had too much left to receive
+	Int compressionThreshold;					   // Packets at least this big are compressed (negative if compression is off)
 	Int protocolVersion;						   // The version of the network protocol the client is using
 	Int entityID;								   // The player's unique entity id
 	SOCKET socket;								   // The socket the player is currently connected on
@@ -53,6 +74,10 @@ protected:
 public:
 	AtomicSet< std::pair<Int, Int> > loadedChunks; // All of the chunks that the client currently has loaded (x, z)
 	JobQueue jobs;								   // Add jobs here to process work on that client's thread
+	RingBuffer received;						   // Bytes the client sent that don't make up a whole packet yet
+	OutboundQueue outbound;						   // Packets waiting to be sent to the client
+	std::deque<DeferredChunk> deferredChunks;	   // Chunks waiting to be streamed to the client (server thread only)
+	NetworkThread* networkThread;				   // The network thread that owns the client's socket
 
 	// Default constructor
 	Client(SOCKET newClient);
@@ -73,6 +98,8 @@ public:
 	const DisplayedSkinParts& getSkinParts(); // Which skin parts are visible on the player model
 	const PlayerAbilities& getAbilities();	  // Whether the client is creative, vulnerable, flying, etc.
 	const Int& getTicksSinceUpdate();		  // How many ticks it's been since a ping
+	const Int& getTicksCongested();			  // How many ticks in a row the client had too much left to receive
+	const Int& getCompressionThreshold();	  // Packets at least this big are compressed (negative if compression is off)
 	const Int& getProtocolVersion();		  // The version of the network protocol the client is using
 	const Int& getEntityID();				  // The player's unique entity id
 	const SOCKET& getSocket();				  // The socket the player is currently connected on
@@ -99,6 +126,9 @@ public:
 	void setAbilities(PlayerAbilities abilities);	 // Whether the client is creative, vulnerable, flying, etc.
 	void resetTicksSinceUpdate();					 // How many ticks it's been since a ping
 	Int incrementTicksSinceUpdate(Int ticks);		 // How many ticks it's been since a ping
+	void resetTicksCongested();						 // How many ticks in a row the client had too much left to receive
+	Int incrementTicksCongested(Int ticks);			 // How many ticks in a row the client had too much left to receive
+	void setCompressionThreshold(Int threshold);	 // Packets at least this big are compressed (negative if compression is off)
 	void setProtocolVersion(Int protocol);			 // The version of the network protocol the client is using
 	void setEntityID(Int EID);						 // The player's unique entity id
 	void setSocket(SOCKET socket);					 // The socket the player is currently connected on
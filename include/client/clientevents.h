@@ -3,6 +3,8 @@
 #include "data/datatypes.h"
 #include "server/serverevents.h"
 
+/* The StringViews point into the packet that raised the event, */
+/* so make a String of any that need to outlive the event */
 class Client;
 class ClientEventArgs
 {
@@ -40,7 +42,7 @@ public:
 	ServerState state;
 	UShort serverPort;
 	Int protocolVersion;
-	String serverAddress;
+	StringView serverAddress;
 };
 
 class LegacyServerListPingEventArgs : public ClientEventArgs
@@ -61,13 +63,13 @@ public:
 	Boolean assumeCommand;
 	Boolean hasPosition;
 	Position lookedAtBlock;
-	String text;
+	StringView text;
 };
 
 class ChatMessageEventArgs : public ClientEventArgs
 {
 public:
-	String message;
+	StringView message;
 };
 
 enum class ClientStatusAction
@@ -126,7 +128,7 @@ public:
 	Byte viewDistance;
 	ChatMode chatMode;
 	DisplayedSkinParts displayedSkinParts;
-	String locale;	// ie. en_US
+	StringView locale;	// ie. en_US
 };
 
 class ConfirmTransactionEventArgs : public ClientEventArgs
@@ -205,7 +207,7 @@ class PluginMessageEventArgs : public ClientEventArgs
 public:
 	Byte* data;
 	Int length;
-	String channel;
+	StringView channel;
 };
 
 enum class EntityInteractType
@@ -432,7 +434,7 @@ public:
 class LoginStartEventArgs : public ClientEventArgs
 {
 public:
-	String name;
+	StringView name;
 };
 
 class EncryptionResponseEventArgs : public ClientEventArgs
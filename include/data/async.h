@@ -0,0 +1,159 @@
+#pragma once
+
+#include "data/threadpool.h"
+#include "data/jobqueue.h"
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+template<typename T>
+class Async;
+
+/******************************************************************
+ * Async Promise Base                                             *
+ * Keeps track of who's waiting on a coroutine. The coroutine can *
+ * finish on any thread, so whichever of it finishing, something  *
+ * awaiting it and its owner letting go of it happens last is     *
+ * what resumes the awaiter or frees the coroutine                *
+ ******************************************************************/
+class AsyncPromiseBase
+{
+protected:
+	enum State { Running, Awaited, Detached, Done };
+	std::atomic<int> state;
+	std::coroutine_handle<> continuation; // Whoever is awaiting the coroutine
+
+	/* Resumes the awaiter or frees a coroutine nobody wants anymore once it's done */
+	struct FinalAwaiter
+	{
+		bool await_ready() noexcept { return false; }
+		template<typename Promise>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+		{
+			AsyncPromiseBase& promise = handle.promise();
+			int previous = promise.state.exchange(Done, std::memory_order_acq_rel);
+			if (previous == Awaited)
+				return promise.continuation;
+			if (previous == Detached)
+				handle.destroy();
+			return std::noop_coroutine();
+		}
+		void await_resume() noexcept {}
+	};
+public:
+	AsyncPromiseBase() : state(Running) {}
+	std::suspend_never initial_suspend() noexcept { return {}; }
+	FinalAwaiter final_suspend() noexcept { return {}; }
+	void unhandled_exception() { std::terminate(); }
+
+	/* Has the awaiter resumed once the coroutine is done, returning false if it's already done so it can carry on */
+	bool await(std::coroutine_handle<> awaiter)
+	{
+		continuation = awaiter;
+		int expected = Running;
+		return state.compare_exchange_strong(expected, Awaited, std::memory_order_acq_rel);
+	}
+
+	/* Lets go of the coroutine, returning true if it's done and it's up to the owner to free it */
+	bool detach() { return state.exchange(Detached, std::memory_order_acq_rel) == Done; }
+	bool done() const { return state.load(std::memory_order_acquire) == Done; }
+};
+
+/* Holds onto what the coroutine returns */
+template<typename T>
+class AsyncPromise : public AsyncPromiseBase
+{
+public:
+	std::optional<T> value;
+	Async<T> get_return_object();
+	template<typename U>
+	void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+	T take() { return std::move(*value); }
+};
+
+template<>
+class AsyncPromise<void> : public AsyncPromiseBase
+{
+public:
+	Async<void> get_return_object();
+	void return_void() {}
+	void take() {}
+};
+
+/******************************************************************
+ * Async                                                          *
+ * A coroutine that starts running as soon as it's called, and    *
+ * gives back a T once it's done. It can be co_awaited from       *
+ * another coroutine, or simply dropped to let it finish on its   *
+ * own (the way the event handlers' are). Where it runs is up to  *
+ * the coroutine: awaiting resumeOn() hops to the thread pool or  *
+ * back to the server thread                                      *
+ ******************************************************************/
+template<typename T = void>
+class Async
+{
+public:
+	typedef AsyncPromise<T> promise_type;
+protected:
+	std::coroutine_handle<promise_type> handle;
+public:
+	explicit Async(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+	Async(Async&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+	Async(const Async&) = delete;
+	Async& operator=(const Async&) = delete;
+	~Async()
+	{
+		if (handle && handle.promise().detach())
+			handle.destroy();
+	}
+
+	bool done() const { return handle.promise().done(); }
+
+	/* Awaiting it resumes the awaiter on whichever thread the coroutine finishes on */
+	bool await_ready() { return handle.promise().done(); }
+	bool await_suspend(std::coroutine_handle<> awaiter) { return handle.promise().await(awaiter); }
+	T await_resume() { return handle.promise().take(); }
+};
+
+template<typename T>
+Async<T> AsyncPromise<T>::get_return_object() { return Async<T>(std::coroutine_handle<AsyncPromise<T>>::from_promise(*this)); }
+inline Async<void> AsyncPromise<void>::get_return_object() { return Async<void>(std::coroutine_handle<AsyncPromise<void>>::from_promise(*this)); }
+
+/**********************************************
+ * Pool Awaiter                               *
+ * Resumes the coroutine on one of the pool's *
+ * workers                                    *
+ **********************************************/
+class PoolAwaiter
+{
+protected:
+	ThreadPool& pool;
+public:
+	PoolAwaiter(ThreadPool& pool) : pool(pool) {}
+	bool await_ready() { return false; }
+	void await_suspend(std::coroutine_handle<> handle) { pool.push([handle]() { handle.resume(); }); }
+	void await_resume() {}
+};
+
+/**********************************************
+ * Job Queue Awaiter                          *
+ * Resumes the coroutine whenever the queue's *
+ * jobs of that priority are run              *
+ **********************************************/
+class JobQueueAwaiter
+{
+protected:
+	PriorityJobQueue& jobs;
+	JobPriority priority;
+public:
+	JobQueueAwaiter(PriorityJobQueue& jobs, JobPriority priority) : jobs(jobs), priority(priority) {}
+	bool await_ready() { return false; }
+	void await_suspend(std::coroutine_handle<> handle) { jobs.push([handle]() { handle.resume(); }, priority); }
+	void await_resume() {}
+};
+
+/* co_await these to carry on somewhere else */
+inline PoolAwaiter resumeOn(ThreadPool& pool) { return PoolAwaiter(pool); }
+inline JobQueueAwaiter resumeOn(PriorityJobQueue& jobs, JobPriority priority = JobPriority::Normal) { return JobQueueAwaiter(jobs, priority); }
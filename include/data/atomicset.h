@@ -1,6 +1,7 @@
 #pragma once
 
 #include <set>
+#include <vector>
 #include <mutex>
 #include <memory>
 #include <functional>
@@ -29,26 +30,26 @@ public:
 	typedef typename std::set<T, Compare, Alloc>::const_reverse_iterator set_crit;
 
 	// Default constructor
-	explicit AtomicSet<T, Compare, Alloc>(const key_compare& comp = key_compare(), const allocator_type& alloc = allocator_type()) : dataLock(new std::mutex()), data(comp, alloc) {}
-	explicit AtomicSet<T, Compare, Alloc>(const allocator_type& alloc) : dataLock(new std::mutex()), data(alloc) {}
+	explicit AtomicSet(const key_compare& comp = key_compare(), const allocator_type& alloc = allocator_type()) : dataLock(new std::mutex()), data(comp, alloc) {}
+	explicit AtomicSet(const allocator_type& alloc) : dataLock(new std::mutex()), data(alloc) {}
 
 	// Copy constructor
-	AtomicSet<T, Compare, Alloc>(const AtomicSet<T, Compare, Alloc>& rhs) : dataLock(new std::mutex()), data(rhs.data) {}
-	AtomicSet<T, Compare, Alloc>(const AtomicSet<T, Compare, Alloc>& rhs, const allocator_type& alloc) : dataLock(new std::mutex()), data(rhs.data, alloc) {}
+	AtomicSet(const AtomicSet<T, Compare, Alloc>& rhs) : dataLock(new std::mutex()), data(rhs.data) {}
+	AtomicSet(const AtomicSet<T, Compare, Alloc>& rhs, const allocator_type& alloc) : dataLock(new std::mutex()), data(rhs.data, alloc) {}
 
 	// Range constructor
 	template <class InputIterator>
-	AtomicSet<T, Compare, Alloc>(InputIterator first, InputIterator last, const key_compare& comp = key_compare(), const allocator_type& alloc = allocator_type()) : dataLock(new std::mutex()), data(first.it, last.it, comp, alloc) {}
+	AtomicSet(InputIterator first, InputIterator last, const key_compare& comp = key_compare(), const allocator_type& alloc = allocator_type()) : dataLock(new std::mutex()), data(first.it, last.it, comp, alloc) {}
 
 	// Move constructor
-	AtomicSet<T, Compare, Alloc>(const AtomicSet<T, Compare, Alloc>&& rhs) : dataLock(std::move(rhs.dataLock)), data(std::move(rhs.data)) { rhs.dataLock = NULL; }
-	AtomicSet<T, Compare, Alloc>(const AtomicSet<T, Compare, Alloc>&& rhs, const allocator_type& alloc) : dataLock(std::move(rhs.dataLock)), data(std::move(rhs.data), alloc) { rhs.dataLock = NULL; }
+	AtomicSet(const AtomicSet<T, Compare, Alloc>&& rhs) : dataLock(std::move(rhs.dataLock)), data(std::move(rhs.data)) { rhs.dataLock = NULL; }
+	AtomicSet(const AtomicSet<T, Compare, Alloc>&& rhs, const allocator_type& alloc) : dataLock(std::move(rhs.dataLock)), data(std::move(rhs.data), alloc) { rhs.dataLock = NULL; }
 
 	// Initializer list constructor
-	AtomicSet<T, Compare, Alloc>(std::initializer_list<T> il, const key_compare& comp = key_compare(), const allocator_type& alloc = allocator_type()) : dataLock(new std::mutex()), data(il, comp, alloc) {}
+	AtomicSet(std::initializer_list<T> il, const key_compare& comp = key_compare(), const allocator_type& alloc = allocator_type()) : dataLock(new std::mutex()), data(il, comp, alloc) {}
 
 	// Destructor
-	~AtomicSet<T, Compare, Alloc>() { if (dataLock) delete dataLock; }
+	~AtomicSet() { if (dataLock) delete dataLock; }
 
 	// Return the comparison objects
 	key_compare key_comp() const { return data.key_comp(); }
@@ -106,6 +107,12 @@ public:
 		return data.count(val);
 	}
 
+	// Copy the contents out all at once, to walk through while other threads change the set
+	std::vector<T> snapshot() const {
+		std::lock_guard<std::mutex> lock(*dataLock);
+		return std::vector<T>(data.begin(), data.end());
+	}
+
 	/**************************
 	 * Atomic Set :: Iterator *
 	 **************************/
@@ -116,7 +123,7 @@ public:
 		std::mutex* dataLock;
 
 		// Constructor from set iterator
-		iterator(set_it& rhs, std::mutex* dataLock) : it(rhs), dataLock(dataLock) {}
+		iterator(const set_it& rhs, std::mutex* dataLock) : it(rhs), dataLock(dataLock) {}
 	public:
 		// Constructors
 		iterator() : it(), dataLock(NULL) {}
@@ -165,7 +172,7 @@ public:
 		std::mutex* dataLock;
 
 		// Constructor from set iterator
-		const_iterator(set_cit& rhs, std::mutex* dataLock) : it(rhs), dataLock(dataLock) {}
+		const_iterator(const set_cit& rhs, std::mutex* dataLock) : it(rhs), dataLock(dataLock) {}
 	public:
 		// Constructors
 		const_iterator() : it(), dataLock(NULL) {}
@@ -212,7 +219,7 @@ public:
 		std::mutex* dataLock;
 
 		// Constructor from set iterator
-		reverse_iterator(set_rit& rhs, std::mutex* dataLock) : it(rhs), dataLock(dataLock) {}
+		reverse_iterator(const set_rit& rhs, std::mutex* dataLock) : it(rhs), dataLock(dataLock) {}
 	public:
 		// Constructors
 		reverse_iterator() : it(), dataLock(NULL) {}
@@ -259,7 +266,7 @@ public:
 		std::mutex* dataLock;
 
 		// Constructor from set iterator
-		const_reverse_iterator(set_crit& rhs, std::mutex* dataLock) : it(rhs), dataLock(dataLock) {}
+		const_reverse_iterator(const set_crit& rhs, std::mutex* dataLock) : it(rhs), dataLock(dataLock) {}
 	public:
 		// Constructors
 		const_reverse_iterator() : it(), dataLock(NULL) {}
@@ -369,7 +376,7 @@ public:
 	template <class... Args>
 	std::pair<iterator, bool> emplace(Args&&... args) {
 		std::lock_guard<std::mutex> lock(*dataLock);
-		std::pair<set_it, bool> temp = data.emplace(args);
+		std::pair<set_it, bool> temp = data.emplace(std::forward<Args>(args)...);
 		return std::make_pair(iterator(temp.first, dataLock), temp.second);
 	}
 
@@ -377,6 +384,6 @@ public:
 	template <class... Args>
 	iterator emplace_hint(const_iterator position, Args&&... args) {
 		std::lock_guard<std::mutex> lock(*dataLock);
-		return iterator(data.emplace_hint(position.it, args), dataLock);
+		return iterator(data.emplace_hint(position.it, std::forward<Args>(args)...), dataLock);
 	}
 };
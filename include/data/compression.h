@@ -0,0 +1,10 @@
+#pragma once
+
+#include "data/datatypes.h"
+
+/* Deflates the data with the calling thread's own zlib stream and appends it to out */
+Boolean deflateData(const char* data, size_t length, String& out, Int level);
+
+/* Inflates the data with the calling thread's own zlib stream */
+/* Fails unless it inflates to exactly outLength bytes         */
+Boolean inflateData(const Byte* data, size_t length, Byte* out, size_t outLength);
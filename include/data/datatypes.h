@@ -4,11 +4,17 @@
 #include "data/biomes.h"
 #include <stdint.h>
 #include <string>
+#include <string_view>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 // Size definitions
 #define VARINT_MAX_SIZE			5
 #define VARLONG_MAX_SIZE		10
-#define VARNUM_MAX_SIZE			100
 #define SERIALSTRING_MAX_LENGTH	32767
 #define SERIALSTRING_MAX_SIZE	131071
 
@@ -25,29 +31,82 @@ typedef uint64_t ULong;
 typedef float Float;
 typedef double Double;
 typedef std::string String;
+typedef std::string_view StringView; // Text owned by something else, like a packet
 class Client;
 
-/**************************
- * VarNum                 *
- * Variable length BigNum *
- **************************/
+/*******************************************
+ * countLeadingZeros                       *
+ * How many of the top bits are zero       *
+ * The value can't be zero                 *
+ *******************************************/
+#ifdef _MSC_VER
+inline Int countLeadingZeros(UInt value) { unsigned long index; _BitScanReverse(&index, value); return 31 - (Int)index; }
+inline Int countLeadingZeros(ULong value)
+{
+	UInt high = (UInt)(value >> 32);
+	return high != 0 ? countLeadingZeros(high) : 32 + countLeadingZeros((UInt)value);
+}
+#else
+inline Int countLeadingZeros(UInt value) { return __builtin_clz(value); }
+inline Int countLeadingZeros(ULong value) { return __builtin_clzll(value); }
+#endif
+
+/***********************************************
+ * VarNum                                      *
+ * Variable length number, stored right in the *
+ * object so that it never touches the heap    *
+ ***********************************************/
+template <typename T, Byte MaxSize>
 class VarNum
 {
 protected:
-	Byte  length; // Length of the array
-	Byte* data;   // The data
-	VarNum(Byte* data = 0);
-	VarNum(const Long value);
-	VarNum(const Int value);
-	VarNum(const VarNum& value);
-	VarNum(VarNum&& value);
-	~VarNum();
-	Long toNum() const;
+	typedef typename std::make_unsigned<T>::type Bits;
+	Byte length;        // How many bytes of data are used
+	Byte data[MaxSize]; // The encoded number
+	VarNum(T value = 0) : length(encode(value, data)) {}
+	VarNum(const Byte* bytes) { decode(bytes, &length); memcpy(data, bytes, length); }
 public:
-	const Byte getSize() const;
-	const Byte* getData() const;
-	friend void makeNumVar(Long value, const Byte maxlength, VarNum& num);
-	friend void makeNumVar(Int value, const Byte maxlength, VarNum& num);
+	const Byte getSize() const { return length; }
+	const Byte* getData() const { return data; }
+
+	/* How many bytes value takes up, worked out from its highest bit instead of a loop */
+	static Byte sizeOf(T value)
+	{
+		Int bits = (Int)sizeof(Bits) * 8 - countLeadingZeros((Bits)((Bits)value | 1));
+		return (Byte)((bits + 6) / 7);
+	}
+
+	/* Writes value into out (which needs MaxSize bytes of room) and returns how many bytes it took */
+	static Byte encode(T value, Byte* out)
+	{
+		Bits bits = (Bits)value;
+		Byte size = sizeOf(value);
+		for (Byte i = 0; i < size - 1; ++i)
+		{
+			out[i] = (Byte)(bits | 0x80);
+			bits >>= 7;
+		}
+		out[size - 1] = (Byte)bits;
+		return size;
+	}
+
+	/* Reads a number out of in, storing how many bytes it took in size (if given) */
+	/* Throws an overflow_error if it doesn't end within MaxSize bytes             */
+	static T decode(const Byte* in, Byte* size = NULL)
+	{
+		Bits result = 0;
+		for (Byte i = 0; i < MaxSize; ++i)
+		{
+			result |= (Bits)(in[i] & 0x7f) << (7 * i);
+			if ((in[i] & 0x80) == 0)
+			{
+				if (size != NULL)
+					*size = i + 1;
+				return (T)result;
+			}
+		}
+		throw std::overflow_error("VarNum is too big");
+	}
 };
 
 /**********************************
@@ -55,32 +114,28 @@ public:
  * Variable length 32-bit integer *
  **********************************/
 class VarLong;
-class VarInt : public VarNum
+class VarInt : public VarNum<Int, VARINT_MAX_SIZE>
 {
 public:
-	VarInt(Byte* data = 0);
-	VarInt(const VarInt& value);
-	VarInt(const Int value);
+	VarInt() {}
+	explicit VarInt(const Byte* data) : VarNum(data) {}
+	VarInt(const Int value) : VarNum(value) {}
 	VarInt(const VarLong& value);
-	~VarInt();
-	VarInt& operator=(const VarInt& right);
-	Int toInt() const;
+	Int toInt() const { return decode(data); }
 };
 
 /**********************************
  * VarLong                        *
  * Variable length 64-bit integer *
  **********************************/
-class VarLong : public VarNum
+class VarLong : public VarNum<Long, VARLONG_MAX_SIZE>
 {
 public:
-	VarLong(Byte* data = 0);
-	VarLong(const VarLong& value);
-	VarLong(const Long value);
-	VarLong(const VarInt& value);
-	~VarLong();
-	VarLong& operator=(const VarLong& right);
-	Long toLong() const;
+	VarLong() {}
+	explicit VarLong(const Byte* data) : VarNum(data) {}
+	VarLong(const Long value) : VarNum(value) {}
+	VarLong(const VarInt& value) : VarNum((Long)value.toInt()) {}
+	Long toLong() const { return decode(data); }
 };
 
 /*******************************************
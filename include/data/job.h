@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+// How big a job can be before it has to go on the heap (with the ops pointer that makes 64 bytes)
+#define JOB_INLINE_SIZE 56
+
+/******************************************************************
+ * Job                                                            *
+ * Something to call later, like a std::function but only ever    *
+ * moved. Anything up to JOB_INLINE_SIZE bytes (which is a lambda *
+ * with a handful of captures) is stored right in the job, so     *
+ * making one and passing it through a queue never allocates      *
+ ******************************************************************/
+class Job
+{
+protected:
+	struct Ops
+	{
+		void (*call)(void* storage);
+		void (*move)(void* from, void* to); // Moves the callable into empty storage and destroys the old one
+		void (*destroy)(void* storage);
+	};
+
+	/* Callables that fit are kept in the storage */
+	template<typename F>
+	struct Inline
+	{
+		static void call(void* storage) { (*(F*)storage)(); }
+		static void move(void* from, void* to) { new (to) F(std::move(*(F*)from)); ((F*)from)->~F(); }
+		static void destroy(void* storage) { ((F*)storage)->~F(); }
+		static constexpr Ops ops = { &call, &move, &destroy };
+	};
+
+	/* Bigger ones are kept on the heap, with the pointer in the storage */
+	template<typename F>
+	struct Heap
+	{
+		static void call(void* storage) { (**(F**)storage)(); }
+		static void move(void* from, void* to) { *(F**)to = *(F**)from; }
+		static void destroy(void* storage) { delete *(F**)storage; }
+		static constexpr Ops ops = { &call, &move, &destroy };
+	};
+
+	template<typename F>
+	static constexpr bool fitsInline = sizeof(F) <= JOB_INLINE_SIZE && alignof(F) <= alignof(std::max_align_t)
+		&& std::is_nothrow_move_constructible<F>::value;
+
+	alignas(std::max_align_t) unsigned char storage[JOB_INLINE_SIZE];
+	const Ops* ops; // NULL for an empty job
+public:
+	Job() : ops(NULL) {}
+
+	template<typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, Job>::value>>
+	Job(F&& fn)
+	{
+		typedef std::decay_t<F> Callable;
+		if constexpr (fitsInline<Callable>)
+		{
+			new (storage) Callable(std::forward<F>(fn));
+			ops = &Inline<Callable>::ops;
+		}
+		else
+		{
+			*(Callable**)storage = new Callable(std::forward<F>(fn));
+			ops = &Heap<Callable>::ops;
+		}
+	}
+
+	Job(Job&& other) noexcept : ops(other.ops)
+	{
+		if (ops != NULL)
+			ops->move(other.storage, storage);
+		other.ops = NULL;
+	}
+
+	Job& operator=(Job&& other) noexcept
+	{
+		if (this != &other)
+		{
+			reset();
+			ops = other.ops;
+			if (ops != NULL)
+				ops->move(other.storage, storage);
+			other.ops = NULL;
+		}
+		return *this;
+	}
+
+	Job(const Job&) = delete;
+	Job& operator=(const Job&) = delete;
+	~Job() { reset(); }
+
+	/* Runs the job */
+	void operator()() { ops->call(storage); }
+
+	/* Throws away whatever the job holds */
+	void reset()
+	{
+		if (ops != NULL)
+			ops->destroy(storage);
+		ops = NULL;
+	}
+
+	explicit operator bool() const { return ops != NULL; }
+};
@@ -1,27 +1,81 @@
 #pragma once
 
-#include <queue>
-#include <mutex>
 #include <atomic>
 #include <thread>
-#include <functional>
+#include <chrono>
+#include "data/job.h"
 
+/******************************************************************
+ * Job Queue                                                      *
+ * A lock-free queue that any number of threads can push jobs to, *
+ * and one thread at a time runs them. Pushing never blocks, and  *
+ * a queue running on its own thread sleeps until a job comes in  *
+ ******************************************************************/
 class JobQueue
 {
 private:
+	struct Node
+	{
+		std::atomic<Node*> next;
+		Job job;
+	};
 	std::thread jobThread;
-	std::mutex queueLock;
-	std::queue< std::function<void()> > jobQueue;
+	std::atomic<Node*> head;     // The last job pushed, which producers swap their jobs in after
+	Node* tail;                  // The next job to run (only touched by the thread running the jobs)
+	Node stub;                   // Sits in the queue whenever it would otherwise be empty
+	std::atomic<int> count;      // How many jobs are waiting
+	std::atomic<unsigned> wakeups; // Bumped to wake the thread running the jobs
+	std::atomic<bool> sleeping;  // Whether that thread is (about to be) asleep
 	std::atomic<bool> running;
+	void link(Node* node);
+	Node* pop();
+	void wake();
 	bool executeJobs(bool waitForJobs);
 public:
-	JobQueue() {}
-	~JobQueue() { stop(); }
+	JobQueue();
+	~JobQueue();
 	bool start(bool runAsync = true);
-	int size();
-	void push(const std::function<void()> job);
-	void stop() { running.store(false); }
+	int size() { return count.load(); }
+	void push(Job job);
+	bool runOne();
+	void stop() { running.store(false); wake(); }
 	bool empty() { return !size(); }
 	bool isRunning() { return running.load(); }
 	bool isExecuting() { return size() && running.load(); }
-};
\ No newline at end of file
+};
+
+// How urgent a job is, from the lane that runs first to the one that runs last
+enum class JobPriority
+{
+	Critical, // Anything a player would notice being late, like keep alives and movement
+	Normal,
+	Bulk      // Big piles of work that can be spread out, like chunk generation
+};
+#define JOB_PRIORITIES 3
+
+// How many times a lane with jobs waiting can be passed over for the ones ahead of it before it gets a turn
+#define JOB_LANE_PATIENCE 16
+
+/******************************************************************
+ * Priority Job Queue                                             *
+ * A job queue for every priority. Jobs run from the most urgent  *
+ * lane that has any, except that a lane that keeps getting       *
+ * passed over eventually gets a turn, so a flood of urgent jobs  *
+ * slows the others down but never stops them                     *
+ ******************************************************************/
+class PriorityJobQueue
+{
+private:
+	JobQueue lanes[JOB_PRIORITIES];
+	int passedOver[JOB_PRIORITIES]; // How many jobs ran ahead of the lane's since it last had a turn
+	int pick(JobPriority lowest);
+public:
+	PriorityJobQueue();
+	void push(Job job, JobPriority priority = JobPriority::Normal) { lanes[(int)priority].push(std::move(job)); }
+	int size(JobPriority priority) { return lanes[(int)priority].size(); }
+	int size();
+	bool empty() { return !size(); }
+
+	/* Runs the jobs down to the lowest priority until there are none left or the deadline passes (after one job at least) */
+	int run(JobPriority lowest, std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max());
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "data/datatypes.h"
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <atomic>
+
+// Small packets get packed together into buffers of this size
+#define OUTBOUND_CHUNK_SIZE 16384
+
+// The most pieces of the queue handed to a writer at once
+#define OUTBOUND_MAX_SLICES 64
+
+// A piece of the queue that's waiting to be written
+struct OutboundSlice
+{
+	const char* data;
+	size_t length;
+};
+
+// A packet that another thread is still working on (like one of the compression workers)
+// It holds up everything queued behind it until it's marked ready, and can be waited on
+// by more than one queue, which all end up sharing its data
+struct OutboundPending
+{
+	std::atomic<bool> ready;
+	std::shared_ptr<const String> data;
+	OutboundPending() : ready(false) {}
+};
+
+// One of the buffers in the queue
+struct OutboundBuffer
+{
+	String data;
+	std::shared_ptr<const String> shared;     // Set instead of data when the buffer is shared with other queues
+	std::shared_ptr<OutboundPending> pending; // Set until the buffer's data is ready
+	size_t estimate;                          // How big the data was guessed to be while it was pending
+	OutboundBuffer() : estimate(0) {}
+	const String& getData() const { return shared ? *shared : data; }
+};
+
+/**************************************************************
+ * Outbound Queue                                             *
+ * A chain of buffers holding the packets that are waiting to *
+ * be sent to a client, so that they can all go out in a      *
+ * single gather write instead of one write per packet        *
+ **************************************************************/
+class OutboundQueue
+{
+protected:
+	std::mutex lock;
+	std::deque<OutboundBuffer> buffers; // The data waiting to be written, in order
+	size_t queued;                      // How many bytes are waiting
+	size_t frontOffset;                 // How much of the front buffer was already written
+	Boolean closed;                     // Whether the client's socket is going away, after which nothing is queued or written
+	Boolean isReady(OutboundBuffer& buffer);
+	Int getSlicesUnlocked(OutboundSlice* slices, Int maxSlices);
+	void consumeUnlocked(size_t count);
+public:
+	OutboundQueue() : queued(0), frontOffset(0), closed(false) {}
+	void push(const char* data, size_t length);
+	void push(String&& data);
+	void push(const std::shared_ptr<const String>& data);
+	std::shared_ptr<OutboundPending> pushPending(size_t estimate);
+	void pushPending(const std::shared_ptr<OutboundPending>& pending, size_t estimate);
+	size_t size();
+	Boolean empty() { return size() == 0; }
+	Int getSlices(OutboundSlice* slices, Int maxSlices);
+	void consume(size_t count);
+	void swap(OutboundQueue& rhs);
+	void moveReadyTo(OutboundQueue& rhs);
+	void clear();
+	Boolean close();
+	Boolean isClosed();
+
+	/*************************************************************
+	 * Outbound Queue :: Flush                                   *
+	 * Writes out as much of the queue as the writer will take.  *
+	 * The writer is given the next pieces of the queue and      *
+	 * returns how many bytes it wrote, or a negative number if  *
+	 * it failed. Stops at the first packet that isn't ready.    *
+	 * Returns how many bytes were written in total, or the      *
+	 * writer's error if it failed before writing any. Nothing   *
+	 * is written once the queue is closed                       *
+	 *************************************************************/
+	template <class Writer>
+	Long flush(Writer write)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		Long total = 0;
+		if (closed)
+			return 0;
+		while (queued > 0)
+		{
+			// Hand the writer the front of the queue
+			OutboundSlice slices[OUTBOUND_MAX_SLICES];
+			Int count = getSlicesUnlocked(slices, OUTBOUND_MAX_SLICES);
+			if (count == 0)
+				break; // The front is still pending
+			size_t offered = 0;
+			for (Int i = 0; i < count; ++i)
+				offered += slices[i].length;
+
+			// Drop whatever it wrote
+			Long wrote = write(slices, count);
+			if (wrote <= 0)
+				return total > 0 ? total : wrote;
+			consumeUnlocked((size_t)wrote);
+			total += wrote;
+
+			// If it couldn't take everything then there's no use trying again right now
+			if ((size_t)wrote < offered)
+				break;
+		}
+
+		return total;
+	}
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "data/packetwriter.h"
+
+/******************************************************************
+ * Packet Reader                                                  *
+ * Reads a packet's data while making sure nothing is read past   *
+ * its end. Once a read runs out of data the reader fails and     *
+ * every read after it gives back zeros                           *
+ ******************************************************************/
+class PacketReader
+{
+protected:
+	const Byte* data; // The next byte to read
+	const Byte* end;  // The end of the packet
+	Boolean failed;   // Whether a read ran past the end
+public:
+	PacketReader(const Byte* data, Int length) : data(data), end(data + (length > 0 ? length : 0)), failed(false) {}
+
+	/* Hands back the next length bytes and skips over them, or NULL (and fails) if there aren't that many */
+	const Byte* take(size_t length)
+	{
+		if (failed || (size_t)(end - data) < length)
+		{
+			failed = true;
+			return NULL;
+		}
+		const Byte* bytes = data;
+		data += length;
+		return bytes;
+	}
+
+	/* Reads a number stored in network order */
+	static UShort load16(const Byte* bytes)
+	{
+		UShort value;
+		memcpy(&value, bytes, sizeof(value));
+#ifndef PACKETWRITER_BIG_ENDIAN
+		value = PACKETWRITER_BSWAP16(value);
+#endif
+		return value;
+	}
+	static UInt load32(const Byte* bytes)
+	{
+		UInt value;
+		memcpy(&value, bytes, sizeof(value));
+#ifndef PACKETWRITER_BIG_ENDIAN
+		value = PACKETWRITER_BSWAP32(value);
+#endif
+		return value;
+	}
+	static ULong load64(const Byte* bytes)
+	{
+		ULong value;
+		memcpy(&value, bytes, sizeof(value));
+#ifndef PACKETWRITER_BIG_ENDIAN
+		value = PACKETWRITER_BSWAP64(value);
+#endif
+		return value;
+	}
+
+	/* Readers for every type a packet can hold */
+	Byte readByte() { const Byte* bytes = take(1); return bytes ? *bytes : 0; }
+	Boolean readBoolean() { return readByte() != 0; }
+	Short readShort() { const Byte* bytes = take(2); return bytes ? (Short)load16(bytes) : 0; }
+	Int readInt() { const Byte* bytes = take(4); return bytes ? (Int)load32(bytes) : 0; }
+	Long readLong() { const Byte* bytes = take(8); return bytes ? (Long)load64(bytes) : 0; }
+	Float readFloat() { UInt bits = (UInt)readInt(); Float value; memcpy(&value, &bits, sizeof(value)); return value; }
+	Double readDouble() { ULong bits = (ULong)readLong(); Double value; memcpy(&value, &bits, sizeof(value)); return value; }
+	Int readVarInt();
+	Long readVarLong();
+	void readVarInts(Int* out, size_t count);
+	StringView readStringView(Int maxLength = SERIALSTRING_MAX_LENGTH);
+	String readString(Int maxLength = SERIALSTRING_MAX_LENGTH) { return String(readStringView(maxLength)); }
+
+	/* Whether a read ran past the end of the packet */
+	Boolean hasFailed() const { return failed; }
+
+	/* How many bytes are left to read */
+	Int getRemaining() const { return (Int)(end - data); }
+};
@@ -0,0 +1,283 @@
+#pragma once
+
+#include "data/packetreader.h"
+#include "data/packetwriter.h"
+#include <type_traits>
+#include <utility>
+
+// The size of a field whose size depends on its value
+#define PACKET_FIELD_VARIABLE -1
+
+/*****************************************************************
+ * Packet Codecs                                                 *
+ * How each type is stored in a packet. Fixed size codecs read   *
+ * straight out of memory that's already been bounds checked,   *
+ * variable size ones read through the PacketReader              *
+ *****************************************************************/
+struct ByteCodec
+{
+	typedef Byte Type;
+	static constexpr Int size = 1;
+	static Type load(const Byte*& data) { return *data++; }
+	static void write(PacketWriter& packet, Type value) { packet.writeByte(value); }
+};
+
+struct UByteCodec
+{
+	typedef UByte Type;
+	static constexpr Int size = 1;
+	static Type load(const Byte*& data) { return (UByte)*data++; }
+	static void write(PacketWriter& packet, Type value) { packet.writeByte((Byte)value); }
+};
+
+struct BooleanCodec
+{
+	typedef Boolean Type;
+	static constexpr Int size = 1;
+	static Type load(const Byte*& data) { return *data++ != 0; }
+	static void write(PacketWriter& packet, Type value) { packet.writeBoolean(value); }
+};
+
+struct ShortCodec
+{
+	typedef Short Type;
+	static constexpr Int size = 2;
+	static Type load(const Byte*& data) { Type value = (Short)PacketReader::load16(data); data += size; return value; }
+	static void write(PacketWriter& packet, Type value) { packet.writeShort(value); }
+};
+
+struct UShortCodec
+{
+	typedef UShort Type;
+	static constexpr Int size = 2;
+	static Type load(const Byte*& data) { Type value = PacketReader::load16(data); data += size; return value; }
+	static void write(PacketWriter& packet, Type value) { packet.writeShort((Short)value); }
+};
+
+struct IntCodec
+{
+	typedef Int Type;
+	static constexpr Int size = 4;
+	static Type load(const Byte*& data) { Type value = (Int)PacketReader::load32(data); data += size; return value; }
+	static void write(PacketWriter& packet, Type value) { packet.writeInt(value); }
+};
+
+struct LongCodec
+{
+	typedef Long Type;
+	static constexpr Int size = 8;
+	static Type load(const Byte*& data) { Type value = (Long)PacketReader::load64(data); data += size; return value; }
+	static void write(PacketWriter& packet, Type value) { packet.writeLong(value); }
+};
+
+struct FloatCodec
+{
+	typedef Float Type;
+	static constexpr Int size = 4;
+	static Type load(const Byte*& data) { UInt bits = PacketReader::load32(data); data += size; Type value; memcpy(&value, &bits, size); return value; }
+	static void write(PacketWriter& packet, Type value) { packet.writeFloat(value); }
+};
+
+struct DoubleCodec
+{
+	typedef Double Type;
+	static constexpr Int size = 8;
+	static Type load(const Byte*& data) { ULong bits = PacketReader::load64(data); data += size; Type value; memcpy(&value, &bits, size); return value; }
+	static void write(PacketWriter& packet, Type value) { packet.writeDouble(value); }
+};
+
+struct PositionCodec
+{
+	typedef Position Type;
+	static constexpr Int size = 8;
+	static Type load(const Byte*& data) { return SerialPosition(LongCodec::load(data)).toPosition(); }
+	static void write(PacketWriter& packet, const Type& value) { packet.writeLong(SerialPosition(value.x, value.y, value.z).getData()); }
+};
+
+struct PositionFCodec
+{
+	typedef PositionF Type;
+	static constexpr Int size = 24;
+	static Type load(const Byte*& data)
+	{
+		Double x = DoubleCodec::load(data);
+		Double y = DoubleCodec::load(data);
+		Double z = DoubleCodec::load(data);
+		return PositionF(x, y, z);
+	}
+	static void write(PacketWriter& packet, const Type& value)
+	{
+		packet.writeDouble(value.x);
+		packet.writeDouble(value.y);
+		packet.writeDouble(value.z);
+	}
+};
+
+struct VarIntCodec
+{
+	typedef Int Type;
+	static constexpr Int size = PACKET_FIELD_VARIABLE;
+	static constexpr Int minSize = 1;
+	static constexpr Int maxSize = 5;
+	static Boolean read(PacketReader& reader, Type& value) { value = reader.readVarInt(); return !reader.hasFailed(); }
+	static void write(PacketWriter& packet, Type value) { packet.writeVarInt(value); }
+};
+
+struct VarLongCodec
+{
+	typedef Long Type;
+	static constexpr Int size = PACKET_FIELD_VARIABLE;
+	static constexpr Int minSize = 1;
+	static constexpr Int maxSize = 10;
+	static Boolean read(PacketReader& reader, Type& value) { value = reader.readVarLong(); return !reader.hasFailed(); }
+	static void write(PacketWriter& packet, Type value) { packet.writeVarLong(value); }
+};
+
+struct StringCodec
+{
+	typedef StringView Type; // Points into the packet, String members get a copy
+	static constexpr Int size = PACKET_FIELD_VARIABLE;
+	static constexpr Int minSize = 1;
+	static constexpr Int maxSize = 3 + SERIALSTRING_MAX_LENGTH * 4; // No character takes more than 4 bytes
+	static Boolean read(PacketReader& reader, Type& value) { value = reader.readStringView(); return !reader.hasFailed(); }
+	static void write(PacketWriter& packet, Type value) { packet.writeString(value); }
+};
+
+/* The fewest and most bytes a value stored with the codec can take up */
+template<typename Codec>
+constexpr Int minSizeOf()
+{
+	if constexpr (Codec::size == PACKET_FIELD_VARIABLE)
+		return Codec::minSize;
+	else
+		return Codec::size;
+}
+template<typename Codec>
+constexpr Int maxSizeOf()
+{
+	if constexpr (Codec::size == PACKET_FIELD_VARIABLE)
+		return Codec::maxSize;
+	else
+		return Codec::size;
+}
+
+/******************************************************
+ * readValue                                          *
+ * Reads a single value with the given codec, making  *
+ * sure there's enough data for it first              *
+ ******************************************************/
+template<typename Codec>
+inline Boolean readValue(PacketReader& reader, typename Codec::Type& value)
+{
+	if constexpr (Codec::size == PACKET_FIELD_VARIABLE)
+		return Codec::read(reader, value);
+	else
+	{
+		const Byte* data = reader.take(Codec::size);
+		if (!data)
+			return false;
+		value = Codec::load(data);
+		return true;
+	}
+}
+
+/*****************************************************************
+ * Field                                                         *
+ * One of a packet's fields, stored with Codec and read into or  *
+ * written from Member (converting between the two types, so     *
+ * enums can be read straight out of the number they're sent as) *
+ *****************************************************************/
+template<typename Codec, auto Member>
+struct Field
+{
+	typedef Codec FieldCodec;
+
+	/* Reads the field from memory that's already been bounds checked */
+	template<typename Args>
+	static void load(const Byte*& data, Args& args)
+	{
+		typedef std::remove_reference_t<decltype(args.*Member)> MemberType;
+		args.*Member = (MemberType)Codec::load(data);
+	}
+
+	/* Reads the field, returning false if the packet ran out of data */
+	template<typename Args>
+	static Boolean read(PacketReader& reader, Args& args)
+	{
+		typedef std::remove_reference_t<decltype(args.*Member)> MemberType;
+		typename Codec::Type value;
+		if (!readValue<Codec>(reader, value))
+			return false;
+		args.*Member = (MemberType)value;
+		return true;
+	}
+
+	/* Writes the field */
+	template<typename Args>
+	static void write(PacketWriter& packet, const Args& args)
+	{
+		Codec::write(packet, (typename Codec::Type)(args.*Member));
+	}
+};
+
+/*****************************************************************
+ * Packet Schema                                                 *
+ * The fields of a packet, in the order they're sent, and where  *
+ * they go in its event's arguments. Packets made entirely of    *
+ * fixed size fields are bounds checked once and then read with  *
+ * no checks at all                                              *
+ *****************************************************************/
+template<typename Args, typename... Fields>
+struct PacketSchema
+{
+	// Whether every field is always the same size
+	static constexpr Boolean fixed = ((Fields::FieldCodec::size != PACKET_FIELD_VARIABLE) && ...);
+
+	// The size of the packet's data (if it's fixed)
+	static constexpr Int size = fixed ? (0 + ... + Fields::FieldCodec::size) : PACKET_FIELD_VARIABLE;
+
+	// The fewest and most bytes the packet's data can be
+	static constexpr Int minSize = (0 + ... + minSizeOf<typename Fields::FieldCodec>());
+	static constexpr Int maxSize = (0 + ... + maxSizeOf<typename Fields::FieldCodec>());
+
+	/* Reads every field into args, returning false if the packet ran out of data */
+	static Boolean read(PacketReader& reader, Args& args)
+	{
+		if constexpr (fixed)
+		{
+			const Byte* data = reader.take(size);
+			if (!data)
+				return false;
+			(Fields::load(data, args), ...);
+			return true;
+		}
+		else
+			return (Fields::read(reader, args) && ...);
+	}
+	static Boolean read(const Byte* buffer, Int length, Args& args)
+	{
+		PacketReader reader(buffer, length);
+		return read(reader, args);
+	}
+
+	/* Writes every field from args */
+	static void write(PacketWriter& packet, const Args& args)
+	{
+		(Fields::write(packet, args), ...);
+	}
+};
+
+/*****************************************************************
+ * Packet Fields                                                 *
+ * The layout of a packet the server sends, which is written     *
+ * straight from the values it's given                           *
+ *****************************************************************/
+template<typename... Codecs>
+struct PacketFields
+{
+	/* Writes each value with its codec */
+	static void write(PacketWriter& packet, const typename Codecs::Type&... values)
+	{
+		(Codecs::write(packet, values), ...);
+	}
+};
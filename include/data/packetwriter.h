@@ -0,0 +1,91 @@
+#pragma once
+
+#include "data/datatypes.h"
+#include <cstring>
+
+#ifdef _MSC_VER
+#include <stdlib.h>
+#define PACKETWRITER_BSWAP16(x) _byteswap_ushort(x)
+#define PACKETWRITER_BSWAP32(x) _byteswap_ulong(x)
+#define PACKETWRITER_BSWAP64(x) _byteswap_uint64(x)
+#else
+#define PACKETWRITER_BSWAP16(x) __builtin_bswap16(x)
+#define PACKETWRITER_BSWAP32(x) __builtin_bswap32(x)
+#define PACKETWRITER_BSWAP64(x) __builtin_bswap64(x)
+#endif
+
+// Big-endian machines already store numbers the way the network wants them
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define PACKETWRITER_BIG_ENDIAN
+#endif
+
+// Room saved in front of every packet for its length (up to 5 bytes) and the
+// uncompressed length of zero that small packets get once compression is on
+#define PACKETWRITER_HEADER_SIZE 6
+
+/******************************************************************
+ * Packet Writer                                                  *
+ * Serializes a packet into a buffer the calling thread reuses    *
+ * for every packet, leaving room in front for the length so      *
+ * that it can be filled in once the body is done. Only one       *
+ * writer per thread can be in use at a time                      *
+ ******************************************************************/
+class PacketWriter
+{
+protected:
+	String& buffer; // The calling thread's buffer
+	size_t start;   // Where the finished packet starts in the buffer
+
+	/* Stores a number in network order in one go */
+	void write16(UShort value)
+	{
+#ifndef PACKETWRITER_BIG_ENDIAN
+		value = PACKETWRITER_BSWAP16(value);
+#endif
+		buffer.append((const char*)&value, sizeof(value));
+	}
+	void write32(UInt value)
+	{
+#ifndef PACKETWRITER_BIG_ENDIAN
+		value = PACKETWRITER_BSWAP32(value);
+#endif
+		buffer.append((const char*)&value, sizeof(value));
+	}
+	void write64(ULong value)
+	{
+#ifndef PACKETWRITER_BIG_ENDIAN
+		value = PACKETWRITER_BSWAP64(value);
+#endif
+		buffer.append((const char*)&value, sizeof(value));
+	}
+public:
+	PacketWriter(Int packetID);
+
+	/* Writers for every type a packet can hold */
+	void writeByte(Byte value) { buffer.push_back((char)value); }
+	void writeBoolean(Boolean value) { buffer.push_back((char)(value ? 1 : 0)); }
+	void writeShort(Short value) { write16((UShort)value); }
+	void writeInt(Int value) { write32((UInt)value); }
+	void writeLong(Long value) { write64((ULong)value); }
+	void writeFloat(Float value) { UInt bits; memcpy(&bits, &value, sizeof(bits)); write32(bits); }
+	void writeDouble(Double value) { ULong bits; memcpy(&bits, &value, sizeof(bits)); write64(bits); }
+	void writeVarInt(Int value) { char data[5]; buffer.append(data, encodeVarInt(data, (UInt)value)); }
+	void writeVarLong(Long value);
+	void writeVarInts(const Int* values, size_t count);
+	void writeString(StringView value) { writeVarInt((Int)value.size()); buffer.append(value.data(), value.size()); }
+	void writeBytes(const void* data, size_t length) { buffer.append((const char*)data, length); }
+
+	/* The packet's id and data */
+	const char* getBody() const { return buffer.data() + PACKETWRITER_HEADER_SIZE; }
+	Int getBodySize() const { return (Int)(buffer.size() - PACKETWRITER_HEADER_SIZE); }
+
+	/* Puts the length in front of the body (and the uncompressed length of zero if compressed) */
+	void finish(Boolean compressed = false);
+
+	/* The finished packet */
+	const char* getData() const { return buffer.data() + start; }
+	size_t getSize() const { return buffer.size() - start; }
+
+	/* Writes value as a VarInt into out (which needs 5 bytes of room) and returns how many bytes it took */
+	static Int encodeVarInt(char* out, UInt value) { return VarInt::encode((Int)value, (Byte*)out); }
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "data/datatypes.h"
+
+// Buffers bigger than this are freed once they've been emptied out
+#define RINGBUFFER_MAX_IDLE_CAPACITY 65536
+
+/*********************************************************
+ * Ring Buffer                                           *
+ * A growable circular buffer of bytes. Data is appended *
+ * at the back and consumed from the front, and any part *
+ * of it can be viewed in place without copying it out   *
+ *********************************************************/
+class RingBuffer
+{
+protected:
+	Byte* data;   // The buffer itself
+	Int capacity; // How many bytes fit in the buffer (always 0 or a power of two)
+	Int head;     // Where the first byte is
+	Int length;   // How many bytes are stored
+	void resize(Int newCapacity);
+	RingBuffer(const RingBuffer& rhs);
+	RingBuffer& operator=(const RingBuffer& rhs);
+public:
+	explicit RingBuffer(Int capacity = 0);
+	~RingBuffer() { if (data) delete[] data; }
+	Int size() const { return length; }
+	Int getCapacity() const { return capacity; }
+	Boolean empty() const { return length == 0; }
+	Byte operator[](Int index) const { return data[(head + index) & (capacity - 1)]; }
+	void reserve(Int size);
+	void append(const Byte* bytes, Int count);
+	Byte* peek(Int count);
+	void consume(Int count);
+	void clear();
+};
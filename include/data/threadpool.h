@@ -0,0 +1,134 @@
+#pragma once
+
+#include "data/datatypes.h"
+#include "data/job.h"
+#include <atomic>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class ThreadPool;
+
+/******************************************************************
+ * Task Group                                                     *
+ * Counts the tasks that were started in it so that whoever       *
+ * started them can wait for all of them to finish                *
+ ******************************************************************/
+class TaskGroup
+{
+protected:
+	std::atomic<Int> pending;
+public:
+	TaskGroup() : pending(0) {}
+	Boolean done() const { return pending.load(std::memory_order_acquire) == 0; }
+	friend class ThreadPool;
+};
+
+/******************************************************************
+ * Work Stealing Deque                                            *
+ * A Chase-Lev deque. Its worker pushes and takes tasks at the    *
+ * bottom without locking, and the other workers steal from the   *
+ * top when they run out of their own                             *
+ ******************************************************************/
+class WorkStealingDeque
+{
+public:
+	struct Task
+	{
+		Job job;
+		TaskGroup* group;
+	};
+protected:
+	struct Ring
+	{
+		Long size;
+		std::atomic<Task*>* tasks;
+		Ring(Long size) : size(size), tasks(new std::atomic<Task*>[size]) {}
+		~Ring() { delete[] tasks; }
+		Task* get(Long i) { return tasks[i & (size - 1)].load(std::memory_order_relaxed); }
+		void put(Long i, Task* task) { tasks[i & (size - 1)].store(task, std::memory_order_relaxed); }
+	};
+	std::atomic<Long> top;
+	std::atomic<Long> bottom;
+	std::atomic<Ring*> ring;
+	std::vector<Ring*> retired; // Rings that were outgrown, which thieves might still be reading
+public:
+	WorkStealingDeque(Long size = 256);
+	~WorkStealingDeque();
+	void push(Task* task);  // Owner only
+	Task* take();           // Owner only
+	Task* steal();          // Anyone
+	Boolean empty() const { return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed); }
+};
+
+/******************************************************************
+ * Thread Pool                                                    *
+ * A worker for every core, each with its own deque of tasks.     *
+ * Tasks started on a worker go on its deque and the idle ones    *
+ * steal from the busy ones, while tasks from any other thread    *
+ * are shared out through one queue. Waiting on a group runs      *
+ * tasks instead of blocking, so tasks can start and wait on      *
+ * tasks of their own                                             *
+ ******************************************************************/
+class ThreadPool
+{
+protected:
+	typedef WorkStealingDeque::Task Task;
+	std::vector<std::thread> workers;
+	std::vector<WorkStealingDeque*> deques;
+	std::mutex lock;
+	std::condition_variable wakeup;
+	std::deque<Task*> injected;   // Tasks from threads that aren't workers
+	std::atomic<Int> queued;      // Tasks that haven't been picked up yet
+	std::atomic<Int> sleepers;    // Workers waiting for a task
+	Boolean running;
+
+	void work(Int index);
+	void schedule(Task* task);
+	Task* find(Int index);
+	Task* findInGroup(TaskGroup& group);
+	void execute(Task* task);
+public:
+	ThreadPool(Int numWorkers = 0);
+	~ThreadPool();
+
+	/* Runs the job on one of the workers */
+	void push(Job job) { schedule(new Task{ std::move(job), NULL }); }
+
+	/* Runs the job on one of the workers as part of the group */
+	void run(TaskGroup& group, Job job);
+
+	/* Helps run tasks until every task in the group is done (only the group's own, off of the workers) */
+	void wait(TaskGroup& group);
+
+	/* Calls body(i) for every i in [begin, end), grain at a time, and waits for all of them */
+	template<typename F>
+	void parallelFor(size_t begin, size_t end, F&& body, size_t grain = 1)
+	{
+		if (begin >= end)
+			return;
+		if (grain == 0)
+			grain = 1;
+
+		// Split it into enough pieces to keep everyone busy, and run the first one here
+		size_t pieces = (end - begin + grain - 1) / grain;
+		size_t most = (size_t)(workers.size() + 1) * 4;
+		if (pieces > most)
+			pieces = most;
+		size_t step = (end - begin + pieces - 1) / pieces;
+
+		TaskGroup group;
+		for (size_t start = begin + step; start < end; start += step)
+		{
+			size_t stop = start + step < end ? start + step : end;
+			run(group, [&body, start, stop]() { for (size_t i = start; i < stop; ++i) body(i); });
+		}
+		for (size_t i = begin; i < begin + step && i < end; ++i)
+			body(i);
+		wait(group);
+	}
+
+	Int getNumWorkers() { return (Int)workers.size(); }
+};
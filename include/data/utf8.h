@@ -0,0 +1,17 @@
+#pragma once
+
+#include "data/datatypes.h"
+
+// x86 always has SSE2 when it's 64-bit (and MSVC only says so for 32-bit builds)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UTF8_USE_SSE2
+#endif
+
+/************************************************************
+ * validateUtf8                                             *
+ * Checks that the length bytes at data are well-formed     *
+ * UTF-8. Returns how many characters they hold, counted    *
+ * the way Minecraft limits strings (UTF-16 units, so       *
+ * anything past U+FFFF counts twice), or -1 if they aren't *
+ ************************************************************/
+Int validateUtf8(const Byte* data, size_t length);
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "data/datatypes.h"
+
+// x86 always has SSE2 when it's 64-bit (and MSVC only says so for 32-bit builds)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VARINT_USE_SSE2
+#endif
+#if defined(__AVX2__)
+#define VARINT_USE_AVX2
+#endif
+
+/************************************************************
+ * encodeVarInts                                            *
+ * Writes count values as VarInts into out, which needs     *
+ * room for count * VARINT_MAX_SIZE bytes. Returns how many *
+ * bytes were written                                       *
+ ************************************************************/
+size_t encodeVarInts(const Int* values, size_t count, Byte* out);
+
+/************************************************************
+ * decodeVarInts                                            *
+ * Reads count VarInts out of the length bytes at in.       *
+ * Returns how many bytes they took up, or -1 if the data   *
+ * ran out or held a VarInt that was too long               *
+ ************************************************************/
+Long decodeVarInts(const Byte* in, size_t length, Int* out, size_t count);
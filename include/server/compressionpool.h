@@ -0,0 +1,31 @@
+#pragma once
+
+#include "data/datatypes.h"
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "data/job.h"
+
+/****************************************************************
+ * Compression Pool                                             *
+ * A few threads that do nothing but deflate packets, so that   *
+ * big packets never cost the server thread its tick. Every     *
+ * worker keeps its own zlib stream between jobs                *
+ ****************************************************************/
+class CompressionPool
+{
+protected:
+	std::vector<std::thread> workers;
+	std::mutex lock;
+	std::condition_variable wakeup;
+	std::queue<Job> jobs;
+	Boolean running;
+	void run();
+public:
+	CompressionPool(Int numWorkers = 0);
+	~CompressionPool();
+	void push(Job job);
+	Int getNumWorkers() { return (Int)workers.size(); }
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "client/clientevents.h"
+
+class EventHandler;
+class EventBatch;
+
+/******************************************************************
+ * The events that the network threads queue up for the server    *
+ * thread, with the arguments each one takes. Every EVENT(name,   *
+ * Args) is an EventHandler method that a game can override       *
+ ******************************************************************/
+#define EVENTHANDLER_QUEUED_EVENTS(EVENT) \
+	EVENT(invalidPacket, InvalidPacketEventArgs) \
+	EVENT(invalidState, InvalidStateEventArgs) \
+	EVENT(invalidLength, InvalidLengthEventArgs) \
+	EVENT(clientDisconnect, ClientDisconnectEventArgs) \
+	EVENT(encryptionResponse, EncryptionResponseEventArgs) \
+	EVENT(loginStart, LoginStartEventArgs) \
+	EVENT(animation, AnimationEventArgs) \
+	EVENT(chatMessage, ChatMessageEventArgs) \
+	EVENT(clickWindow, ClickWindowEventArgs) \
+	EVENT(clientSettings, ClientSettingsEventArgs) \
+	EVENT(clientStatus, ClientStatusEventArgs) \
+	EVENT(closeWindow, CloseWindowEventArgs) \
+	EVENT(confirmTransaction, ConfirmTransactionEventArgs) \
+	EVENT(creativeInventoryAction, CreativeInventoryActionEventArgs) \
+	EVENT(enchantItem, EnchantItemEventArgs) \
+	EVENT(entityAction, EntityActionEventArgs) \
+	EVENT(heldItemChange, HeldItemChangeEventArgs) \
+	EVENT(keepAlive, KeepAliveEventArgs) \
+	EVENT(playerAbilities, PlayerAbilitiesEventArgs) \
+	EVENT(playerBlockPlacement, PlayerBlockPlacementEventArgs) \
+	EVENT(playerDigging, PlayerDiggingEventArgs) \
+	EVENT(playerLook, PlayerLookEventArgs) \
+	EVENT(playerOnGround, PlayerOnGroundEventArgs) \
+	EVENT(playerPosition, PlayerPositionEventArgs) \
+	EVENT(playerPositionAndLook, PlayerPositionAndLookEventArgs) \
+	EVENT(pluginMessage, PluginMessageEventArgs) \
+	EVENT(resourcePackStatus, ResourcePackStatusEventArgs) \
+	EVENT(spectate, SpectateEventArgs) \
+	EVENT(steerBoat, SteerBoatEventArgs) \
+	EVENT(steerVehicle, SteerVehicleEventArgs) \
+	EVENT(tabComplete, TabCompleteEventArgs) \
+	EVENT(teleportConfirm, TeleportConfirmEventArgs) \
+	EVENT(updateSign, UpdateSignEventArgs) \
+	EVENT(useEntity, UseEntityEventArgs) \
+	EVENT(useItem, UseItemEventArgs) \
+	EVENT(vehicleMove, VehicleMoveEventArgs)
+
+/* Which of the queued events an event is */
+#define EVENT_ID(name, Args) name,
+enum class EventID : Int
+{
+	EVENTHANDLER_QUEUED_EVENTS(EVENT_ID)
+	Count
+};
+#undef EVENT_ID
+
+/* The arguments that go with each event */
+template<EventID Event>
+struct EventArgsOf;
+#define EVENT_ARGS_OF(name, Args) template<> struct EventArgsOf<EventID::name> { typedef Args Type; };
+EVENTHANDLER_QUEUED_EVENTS(EVENT_ARGS_OF)
+#undef EVENT_ARGS_OF
+
+/******************************************************************
+ * Event Dispatch                                                 *
+ * The event handler's methods that the rest of the server calls, *
+ * worked out at compile time for whichever game the handler is.  *
+ * Each is one indirect call into code made for that game, which  *
+ * then calls the game's own methods directly (and can inline     *
+ * them), so a whole batch of queued events costs one call        *
+ ******************************************************************/
+struct EventDispatch
+{
+	void (*runBatch)(EventHandler* handler, EventBatch& batch); // Every queued event in the batch, in order
+
+	/* The ones that are called straight away */
+	void (*onTick)(EventHandler* handler, Double dt, Int ticksSkipped);
+	void (*handshake)(EventHandler* handler, HandShakeEventArgs& e);
+	void (*legacyServerListPing)(EventHandler* handler, LegacyServerListPingEventArgs& e);
+	ChunkSection& (*getChunkSection)(EventHandler* handler, GetChunkSectionEventArgs& e);
+	ChunkColumn& (*getChunk)(EventHandler* handler, GetChunkEventArgs& e);
+	BiomeID* (*getBiomes)(EventHandler* handler, GetBiomeEventArgs& e);
+};
@@ -3,10 +3,24 @@
 #include "client/client.h"
 #include "client/clientevents.h"
 #include "data/jobqueue.h"
+#include "data/threadpool.h"
+#include "data/async.h"
 #include "data/atomicset.h"
+#include "server/tickmetrics.h"
+#include "server/eventdispatch.h"
+#include "server/eventqueue.h"
 #include <map>
+#include <vector>
+#include <type_traits>
+#include <chrono>
 #include <thread>
 
+// How many ticks behind the clock can fall before it skips them instead of running them back to back
+#define TICK_CATCHUP_LIMIT 20
+
+// How many seconds of each tick can go to chunk streaming and other work that can wait
+#define TICK_DEFERRED_BUDGET 0.02
+
 class Server;
 class NetworkHandler;
 class EventHandler
@@ -14,12 +28,17 @@ class EventHandler
 private:
 	std::thread tickClock;
 	Double tickDelay;
+	TickMetrics tickMetrics;
+	Double deferredBudget;
 	volatile Boolean running;
 	void runTickClock();
 	void seedNetwork(NetworkHandler* networkHandler);
 protected:
-	JobQueue jobQueue;
+	PriorityJobQueue jobQueue;
+	const EventDispatch* dispatch;	// The game's event methods, which everything outside calls them through
+	ThreadPool pool;	// Workers for anything that can be split up across cores
 	AtomicSet<Client*, ClientComparator> clients;
+	std::vector<Client*> tickClients; // A copy of the clients taken at the start of every tick, which the tick walks through instead
 	NetworkHandler* networkHandler;
 
 	/*****************
@@ -27,6 +46,12 @@ protected:
 	 *****************/
 	void onTick(Double dt, Int ticksSkipped);
 
+	/* The phases of a tick, in the order they run */
+	void tickInbound();
+	void tickWorld(Int ticks);
+	void tickTracking();
+	void tickDeferred();
+
 	/***************************
 	 * CLIENT -> SERVER EVENTS *
 	 ***************************/
@@ -36,14 +61,10 @@ protected:
 	void invalidLength(InvalidLengthEventArgs e);
 	void clientDisconnect(ClientDisconnectEventArgs e);
 
-	/* HANDSHAKING EVENTS */
+	/* HANDSHAKING EVENTS (run on the network threads, which answer status requests themselves) */
 	void handshake(HandShakeEventArgs e);
 	void legacyServerListPing(LegacyServerListPingEventArgs e);
 
-	/* STATUS EVENTS */
-	void ping(PingEventArgs e);
-	void request(RequestEventArgs e);
-
 	/* LOGIN EVENTS */
 	void encryptionResponse(EncryptionResponseEventArgs e);
 	void loginStart(LoginStartEventArgs e);
@@ -52,7 +73,7 @@ protected:
 	void animation(AnimationEventArgs e);
 	void chatMessage(ChatMessageEventArgs e);
 	void clickWindow(ClickWindowEventArgs e);
-	void clientSettings(ClientSettingsEventArgs e);
+	Async<void> clientSettings(ClientSettingsEventArgs e);
 	void clientStatus(ClientStatusEventArgs e);
 	void closeWindow(CloseWindowEventArgs e);
 	void confirmTransaction(ConfirmTransactionEventArgs e);
@@ -80,10 +101,14 @@ protected:
 	void useItem(UseItemEventArgs e);
 	void vehicleMove(VehicleMoveEventArgs e);
 
-	/* DATA-PASSING EVENTS */
+	/* DATA-PASSING EVENTS (called from the thread pool, see BasicEventHandler) */
 	ChunkSection& getChunkSection(GetChunkSectionEventArgs& e);
 	ChunkColumn& getChunk(GetChunkEventArgs& e);
 	BiomeID* getBiomes(GetBiomeEventArgs& e);
+
+	/* Runs a batch of queued events on a game */
+	template <typename Game>
+	static void runBatch(EventHandler* handler, EventBatch& batch);
 public:
 	/* Constructors */
 	EventHandler();
@@ -93,6 +118,11 @@ public:
 	friend class NetworkHandler;
 	friend class Server;
 
+	/* Works out the event methods of a game (or of the plain EventHandler) */
+	template <typename Game>
+	static const EventDispatch& dispatchFor();
+	const EventDispatch& getDispatch() const { return *dispatch; }
+
 	/**********************************************************
 	 * These start and stop the server's tick loop.           *
 	 * They are needed to run logic outside of client events. *
@@ -101,14 +131,53 @@ public:
 	void startTickClock(Double delay = 0.05);
 	void stopTickClock();
 
+	/* Puts work off until a tick has time to spare for it */
+	void defer(Job job) { jobQueue.push(std::move(job), JobPriority::Bulk); }
+
+	/* How many seconds each tick can spend on chunk streaming and deferred work */
+	void setDeferredBudget(Double seconds) { deferredBudget = seconds; }
+	Double getDeferredBudget() { return deferredBudget; }
+
+	/* co_await these to carry on on one of the pool's workers or back on the server thread */
+	PoolAwaiter toPool() { return resumeOn(pool); }
+	JobQueueAwaiter toServerThread(JobPriority priority = JobPriority::Normal) { return resumeOn(jobQueue, priority); }
+
+	/*************************************************************
+	 * EventHandler :: runAsync                                  *
+	 * Runs fn on the thread pool, and has whoever co_awaits it  *
+	 * carry on with what it returned back on the server thread  *
+	 *************************************************************/
+	template <typename F>
+	Async<std::invoke_result_t<F&>> runAsync(F fn, JobPriority priority = JobPriority::Normal)
+	{
+		co_await toPool();
+		if constexpr (std::is_void<std::invoke_result_t<F&>>::value)
+		{
+			fn();
+			co_await toServerThread(priority);
+		}
+		else
+		{
+			std::invoke_result_t<F&> result = fn();
+			co_await toServerThread(priority);
+			co_return result;
+		}
+	}
+
+	/* How long the ticks are taking (MSPT), how many run a second (TPS) and the like */
+	const TickMetrics& getTickMetrics() const { return tickMetrics; }
+
+	/* The workers that chunk loading, serialization and the like fan out to */
+	ThreadPool& getPool() { return pool; }
+
 	/***********************************************************
 	 * EventHandler :: triggerEvent                            *
 	 * Runs the given event (may be run on a different thread) *
 	 ***********************************************************/
 	template <typename T, typename P>
-	void runOnServerThread(T&& fn, EventHandler* eventHandler, P e)
+	void runOnServerThread(T&& fn, EventHandler* eventHandler, P e, JobPriority priority = JobPriority::Normal)
 	{
-		jobQueue.push(std::function<void()>([eventHandler, fn, e]() { ((eventHandler)->*(fn))(e); }));
+		jobQueue.push([eventHandler, fn, e]() { ((eventHandler)->*(fn))(e); }, priority);
 	}
 
 	/***********************************************************
@@ -116,8 +185,81 @@ public:
 	 * Runs the given event (may be run on a different thread) *
 	 ***********************************************************/
 	template <typename T>
-	void runOnServerThread(T&& fn)
+	void runOnServerThread(T&& fn, JobPriority priority = JobPriority::Normal)
+	{
+		jobQueue.push(std::forward<T>(fn), priority);
+	}
+};
+
+/*************************************************************
+ * EventHandler :: dispatchFor                               *
+ * Fills in the event methods of the game once. Each one     *
+ * calls the game's method straight from the game's type, so *
+ * it's the game's own version if it has one                 *
+ *************************************************************/
+template <typename Game>
+const EventDispatch& EventHandler::dispatchFor()
+{
+	static_assert(std::is_base_of<EventHandler, Game>::value, "Games have to be event handlers");
+	static const EventDispatch dispatch = []()
 	{
-		jobQueue.push(std::function<void()>(fn));
+		EventDispatch d;
+		d.runBatch = &runBatch<Game>;
+		d.onTick = [](EventHandler* handler, Double dt, Int ticksSkipped) { static_cast<Game*>(handler)->onTick(dt, ticksSkipped); };
+		d.handshake = [](EventHandler* handler, HandShakeEventArgs& e) { static_cast<Game*>(handler)->handshake(e); };
+		d.legacyServerListPing = [](EventHandler* handler, LegacyServerListPingEventArgs& e) { static_cast<Game*>(handler)->legacyServerListPing(e); };
+		d.getChunkSection = [](EventHandler* handler, GetChunkSectionEventArgs& e) -> ChunkSection& { return static_cast<Game*>(handler)->getChunkSection(e); };
+		d.getChunk = [](EventHandler* handler, GetChunkEventArgs& e) -> ChunkColumn& { return static_cast<Game*>(handler)->getChunk(e); };
+		d.getBiomes = [](EventHandler* handler, GetBiomeEventArgs& e) { return static_cast<Game*>(handler)->getBiomes(e); };
+		return d;
+	}();
+	return dispatch;
+}
+
+/*************************************************************
+ * EventHandler :: runBatch                                  *
+ * Gives every event in the batch to the game, switching on  *
+ * which event it is so each one is a direct call            *
+ *************************************************************/
+template <typename Game>
+void EventHandler::runBatch(EventHandler* handler, EventBatch& batch)
+{
+	Game* game = static_cast<Game*>(handler);
+	for (size_t i = 0; i < batch.records.size(); ++i)
+	{
+		void* e = batch.records[i].e;
+		switch ((EventID)batch.records[i].event)
+		{
+			#define EVENT_CASE(name, Args) case EventID::name: game->name(*(Args*)e); break;
+			EVENTHANDLER_QUEUED_EVENTS(EVENT_CASE)
+			#undef EVENT_CASE
+			default: break; // Data that's only kept for an event
+		}
 	}
-};
\ No newline at end of file
+}
+
+/******************************************************************
+ * Basic Event Handler                                            *
+ * What a game derives from (as class Game : public               *
+ * BasicEventHandler<Game>) to change how the server handles its  *
+ * events. The game declares its own versions of EventHandler's   *
+ * event methods, without them having to be virtual. The server   *
+ * reaches the game through one function pointer per tick, batch  *
+ * of queued events, handshake or chunk, and from there calls the *
+ * game's methods directly (so they can be inlined). If the game  *
+ * keeps them private or protected then it has to befriend        *
+ * EventHandler                                                   *
+ *                                                                *
+ * Threads: every event runs on the server thread, except for the *
+ * data-passing ones. getChunk, getChunkSection and getBiomes are *
+ * called from the thread pool's workers while chunks are being   *
+ * encoded, several at a time, so a game's versions of them must  *
+ * be safe to run concurrently with each other and with the tick  *
+ * (they may only read shared world state, or have to lock it)    *
+ ******************************************************************/
+template <typename Game>
+class BasicEventHandler : public EventHandler
+{
+public:
+	BasicEventHandler() { dispatch = &dispatchFor<Game>(); }
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "data/datatypes.h"
+#include "server/eventdispatch.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <cstddef>
+#include <type_traits>
+
+#define EVENTBATCH_BLOCK_SIZE 16384
+
+class EventHandler;
+
+/*****************************************************************
+ * Event Batch                                                   *
+ * Events a network thread already read out of its packets, each *
+ * kept with the event it is for. The events                     *
+ * and anything they point to (like the text of a chat message)  *
+ * are copied into blocks the batch owns, which are kept around  *
+ * to be filled again once the batch has been run                *
+ *****************************************************************/
+class EventBatch
+{
+protected:
+	struct Record
+	{
+		Int event; // The EventID, or -1 for data that's only kept for an event
+		void (*destroy)(void* e);
+		void* e;
+	};
+	std::vector<Record> records;
+	std::vector< std::unique_ptr<Byte[]> > blocks; // Every block the batch has filled before
+	std::vector< std::unique_ptr<Byte[]> > large;  // Anything too big for a block, freed when the batch is cleared
+	size_t block;                                  // The block being filled
+	size_t used;                                   // How much of that block is filled
+
+	void* allocate(size_t size, size_t alignment);
+
+
+	template<typename T>
+	static void destroyValue(void* value) { ((T*)value)->~T(); }
+
+	/* The event handler runs through the records itself (see EventHandler::runBatch) */
+	friend class EventHandler;
+public:
+	EventBatch() : block(0), used(0) {}
+	EventBatch(const EventBatch&) = delete;
+	EventBatch& operator=(const EventBatch&) = delete;
+	~EventBatch() { clear(); }
+
+	/* Copies the event into the batch, to be given to the event handler when the batch runs */
+	template<EventID Event, typename Args>
+	void push(const Args& e)
+	{
+		static_assert(std::is_same<Args, typename EventArgsOf<Event>::Type>::value, "Those aren't the event's arguments");
+		static_assert(alignof(Args) <= alignof(std::max_align_t), "Events can't need more than the normal alignment");
+		Args* copy = new (allocate(sizeof(Args), alignof(Args))) Args(e);
+		records.push_back({ (Int)Event, &destroyValue<Args>, copy });
+	}
+
+	/* Copies a value into the batch, where it stays until the batch is cleared */
+	template<typename T>
+	T* copy(const T& value)
+	{
+		static_assert(alignof(T) <= alignof(std::max_align_t), "Values can't need more than the normal alignment");
+		T* kept = new (allocate(sizeof(T), alignof(T))) T(value);
+		records.push_back({ -1, &destroyValue<T>, kept });
+		return kept;
+	}
+
+	/* Copies text or data that an event points to into the batch */
+	StringView keep(StringView text);
+	Byte* keep(const Byte* data, Int length);
+
+	/* Runs every event in the order they were pushed, then clears the batch */
+	void run(EventHandler* handler, const EventDispatch& dispatch);
+	void clear();
+	Boolean empty() const { return records.empty(); }
+	size_t size() const { return records.size(); }
+};
+
+/*****************************************************************
+ * Event Queue                                                   *
+ * Where a network thread leaves the events it reads for the     *
+ * server thread. The network thread fills one batch while the   *
+ * server thread runs the other, and they trade every tick       *
+ *****************************************************************/
+class EventQueue
+{
+protected:
+	std::mutex lock;
+	EventBatch batches[2];
+	EventBatch* filling; // The batch events are pushed into
+public:
+	EventQueue() : filling(&batches[0]) {}
+
+	/* Holds the queue while an event (and what it points to) is being pushed */
+	class Writer
+	{
+	protected:
+		std::lock_guard<std::mutex> guard;
+		EventBatch& batch;
+	public:
+		Writer(EventQueue& queue) : guard(queue.lock), batch(*queue.filling) {}
+		EventBatch* operator->() { return &batch; }
+		EventBatch& operator*() { return batch; }
+	};
+
+	/* Runs everything pushed since the last run (server thread only) */
+	void run(EventHandler* handler, const EventDispatch& dispatch);
+};
@@ -4,22 +4,199 @@
 #include "data/datatypes.h"
 #include "data/entity/entities.h"
 #include "data/entity/blockentities.h"
+#include "data/networkpackets.h"
 #include "server/serverevents.h"
+#include "server/eventqueue.h"
+#include "data/packetwriter.h"
+#include "server/compressionpool.h"
+#include "server/serverstatus.h"
 #include <utility>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
 
 #ifdef _WIN32
 #else
 #define closesocket(x) close(x)
 #endif
+
+// Linux gets an edge-triggered epoll reactor, everything else polls with select
+#ifdef __linux__
+#define NETWORK_USE_EPOLL
+#endif
+
+// Define NETWORK_USE_IO_URING (and link against liburing 2.4+) to build the io_uring backend
+#if defined(NETWORK_USE_IO_URING) && !defined(__linux__)
+#undef NETWORK_USE_IO_URING
+#endif
+
+// Platforms that can bind several sockets to one port let every network thread accept its own clients
+#ifdef SO_REUSEPORT
+#define NETWORK_USE_REUSEPORT
+#endif
+
+// Flush a client's outbound queue early once this many bytes are waiting in it
+#define OUTBOUND_FLUSH_THRESHOLD 65536
+
+// Hold chunks back from clients with this many bytes still waiting to be sent
+#define OUTBOUND_HIGH_WATER (1 << 20)
+
+// How many chunk columns a client is streamed at once before the next client gets a turn
+#define CHUNK_STREAM_BATCH 8
+
+// Drop packets for and disconnect clients with this many bytes still waiting to be sent
+#define OUTBOUND_HARD_LIMIT (8 << 20)
+
+// Disconnect clients that stay over the high-water mark for this many ticks
+#define OUTBOUND_MAX_CONGESTED_TICKS 600
+
+// Packets at least this big get compressed once a client logs in (negative turns compression off)
+#define DEFAULT_COMPRESSION_THRESHOLD 256
+
+// How hard zlib works on compressed packets (1 is fastest, 9 is smallest)
+#define DEFAULT_COMPRESSION_LEVEL 6
+
+// The packet ids the dispatch table has room for in every state (UseItem is the highest one a client sends)
+#define PACKET_ID_LIMIT ((Int)ClientPlayPacket::UseItem + 1)
+
+// The states the dispatch table has packets for
+#define PACKET_STATES ((Int)ServerState::Play + 1)
+
+// The ways a NetworkHandler can wait on its clients, chosen when it's created
+enum class NetworkBackend
+{
+	Default, // The best backend this platform was built with (epoll on Linux, select elsewhere)
+	Select,  // A portable select loop
+	Epoll,   // An edge-triggered epoll reactor (Linux only)
+	IoUring  // Multishot receives into provided buffers and batched sends (Linux with liburing only)
+};
+
 class EventHandler;
+#ifdef NETWORK_USE_IO_URING
+struct UringState;
+#endif
+
+/* How many of one packet the network threads have read */
+struct PacketMetrics
+{
+	ULong count;    // Packets that were read
+	ULong bytes;    // The bytes of data they held (not counting their ids)
+	ULong rejected; // Packets that were dropped unread for being a size they can't be
+};
+
+/* A network thread's running counts for one packet, which only the thread itself writes to */
+struct PacketCounters
+{
+	std::atomic<ULong> count;
+	std::atomic<ULong> bytes;
+	std::atomic<ULong> rejected;
+	PacketCounters() : count(0), bytes(0), rejected(0) {}
+};
+
+/******************************************************************
+ * NetworkThread                                                  *
+ * One of the network handler's event loops and the clients it    *
+ * owns. Every thread waits on its own sockets, reads the packets *
+ * that come in on them and hands the events they make to the     *
+ * server thread through its own queue                            *
+ ******************************************************************/
+struct NetworkThread
+{
+	Int id;
+	SOCKET listenSocket;						  // The thread's own listener (INVALID_SOCKET if the server accepts its clients)
+	AtomicSet<Client*, ClientComparator> clients; // The clients whose sockets this thread owns
+	EventQueue events;							  // Events for the server thread, run at the start of every tick
+#ifdef NETWORK_USE_EPOLL
+	int epollFD;								  // The epoll instance the thread's sockets are registered with
+#endif
+#ifdef NETWORK_USE_IO_URING
+	UringState* uring;							  // The ring, its provided buffers and any sends waiting to be submitted
+#endif
+	PacketCounters packets[PACKET_STATES][PACKET_ID_LIMIT]; // What the thread has read of every packet
+	NetworkThread(Int id);
+};
+
 class NetworkHandler
 {
 protected:
 	volatile Boolean running;
 	EventHandler* eventHandler;
+	NetworkBackend backend;
+	std::vector<NetworkThread*> threads; // Every event loop, the first one runs on whichever thread calls start
+	std::vector<std::thread> workers;    // The threads running every other event loop
+	std::atomic<UInt> nextThread;        // Which thread gets the next client the server accepts
+	Int compressionThreshold;            // Packets at least this big get compressed (negative turns compression off)
+	Int compressionLevel;                // How hard zlib works on compressed packets
+	CompressionPool* compressionPool;    // Deflates the packets that are big enough to compress
+	ServerStatus status;                 // What the server list shows, answered by the network threads themselves
+
+	/* Client event loops (every thread runs the same one) */
+	void run(NetworkThread& thread);
+	void runSelect(NetworkThread& thread);
+#ifdef NETWORK_USE_EPOLL
+	void runEpoll(NetworkThread& thread);
+#endif
+#ifdef NETWORK_USE_IO_URING
+	void runUring(NetworkThread& thread);
+#endif
+
+	/* Accepts every client waiting on the thread's listener */
+	void acceptClients(NetworkThread& thread);
+
+	/* Hands a connected socket to the given thread */
+	void addClient(SOCKET newClient, NetworkThread& thread);
+
+	/* Closes the client's socket and lets the server know it left (only from the thread that owns it) */
+	void closeClient(Client* client);
+
+	/* Queues a finished packet up to be sent with the client's next flush */
+	void sendPacket(Client* client, PacketWriter& packet);
+
+	/* Queues a finished packet up for every one of the clients, encoding (and compressing) it only once */
+	void broadcastPacket(const std::vector<Client*>& clients, PacketWriter& packet);
+
+	/* Reads whatever the client sent and every packet in it       */
+	/* Returns true if there may still be more data waiting        */
+	Boolean receiveData(Client* client, Int flags = 0);
+
+	/* Buffer the client's data and read every packet that fully arrived */
+	void receivePackets(Client* client, const Byte* data, Int length);
+
+	/* Inflate a packet sent in the compressed format and read it */
+	/* Returns false if the rest of the stream can't be read      */
+	Boolean readCompressedPacket(Client* client, Byte* buffer, Int length);
+
+	/* Chunk columns, loaded through the event handler and serialized on any thread */
+	void loadChunk(GetChunkEventArgs& e, Boolean createChunk);
+	void writeChunk(PacketWriter& packet, Int x, Int z, ChunkColumn& column, Boolean createChunk, Boolean inOverworld);
 
 	/* Read a packet and trigger the corresponding event below */
-	void readPacket(Client* client, Byte* const buffer, Int length, Boolean deleteBuffer = false);
+	/* Returns false if the rest of the stream can't be read    */
+	Boolean readPacket(Client* client, Byte* buffer, Int length);
+
+	/* How a packet's data is read, and how long it can be. Packets outside */
+	/* of those lengths are turned away before anything reads them          */
+	typedef void (NetworkHandler::*PacketReadFunction)(Client* client, Byte* buffer, Int length);
+	struct PacketHandler
+	{
+		PacketReadFunction read; // NULL if a client can't send it in that state
+		Int minLength;
+		Int maxLength;
+		const char* name;        // What the packet's invalid length events are raised as
+	};
+
+	/* Every packet a client can send, by [state][packet id], built at compile time */
+	struct PacketTable
+	{
+		PacketHandler handlers[PACKET_STATES][PACKET_ID_LIMIT];
+	};
+	static constexpr PacketTable makePacketTable();
+	static const PacketTable packetTable;
+
+	/* Hand an event to the server thread, copying the text the Views members point to */
+	template<EventID Event, typename Args, typename... Views>
+	void queueEvent(Client* client, Int length, const char* cause, Args& e, Boolean valid, Views... views);
 
 	/***************************
 	 * CLIENT -> SERVER EVENTS *
@@ -27,6 +204,10 @@ protected:
 	/* ERROR TRACKING EVENTS */
 	void invalidPacket(Client* client, Byte* buffer, Int length, Int packet);
 	void invalidState(Client* client, Byte* buffer, Int length);
+	void invalidLength(Client* client, Int length, String cause);
+	void malformedPacket(Client* client, Int length, const char* cause);
+	template<typename Args>
+	void truncatedPacket(EventBatch& batch, Int length, const char* cause, const Args& e);
 
 	/* HAND SHAKE EVENTS */
 	void handShake(Client* client, Byte* buffer, Int length);
@@ -105,6 +286,7 @@ public:
 	void sendServerDifficulty(Client* client, Difficulty difficulty);
 	void sendTabComplete(Client* client, String result);
 	void sendChatMessage(Client* client, String message, ChatMessageType type = ChatMessageType::Chat, Boolean isJson = false);
+	void broadcastChatMessage(const std::vector<Client*>& clients, String message, ChatMessageType type = ChatMessageType::Chat, Boolean isJson = false);
 	void sendConfirmTransaction(Client* client, Byte windowID, Short actionNum, Boolean accepted);
 	void sendCloseWindow(Client* client, Byte windowID);
 	void sendOpenWindow(Client* client, Window window);
@@ -126,6 +308,10 @@ public:
 		{ sendChunk(client, chunk.first, chunk.second, createChunk, inOverworld); }
 	void sendChunk(Client* client, std::pair<Int, Int> chunk, ChunkColumn& column, Boolean createChunk = false, Boolean inOverworld = true)
 		{ sendChunk(client, chunk.first, chunk.second, column, createChunk, inOverworld); }
+	void sendChunks(Client* client, const std::vector< std::pair<Int, Int> >& chunks, Boolean createChunk = false, Boolean inOverworld = true);
+	void queueChunks(Client* client, const std::vector< std::pair<Int, Int> >& chunks, Boolean createChunk = false, Boolean inOverworld = true);
+	std::vector< std::shared_ptr<const String> > encodeChunks(Client* client, const std::vector< std::pair<Int, Int> >& chunks, Boolean createChunk = false, Boolean inOverworld = true);
+	void sendEncodedChunks(Client* client, const std::vector< std::pair<Int, Int> >& chunks, const std::vector< std::shared_ptr<const String> >& packets);
 	void sendEffect(Client* client, EffectID effectID, Position pos, Int data = 0, Boolean disableRelativeVolume = false);
 	void sendParticle(Client* client, Particle particle, Int num, Byte* data = NULL, Int dataLen = 0);
 	void sendJoinGame(Client* client, Int entityID, Gamemode gamemode, Dimension dimension, Difficulty difficulty, Byte maxPlayers, LevelType levelType, Boolean reducedDebugInfo = false);
@@ -214,13 +400,28 @@ public:
 	template <class T> // Any IEnumerable like vector<Int>
 	void sendDestroyEntities(Client* client, T entities)
 	{
-
+		// Serialize the data, every id at once
+		std::vector<Int> ids(entities.begin(), entities.end());
+		PacketWriter packet((Int)ServerPlayPacket::DestroyEntities);
+		packet.writeVarInt((Int)ids.size());
+		packet.writeVarInts(ids.data(), ids.size());
+
+		// Send the packet
+		sendPacket(client, packet);
 	}
 
 	template <class T> // Any IEnumerable like vector<Int>
 	void sendSetPassengers(Client* client, Int vehicleID, T passengers)
 	{
-
+		// Serialize the data, every id at once
+		std::vector<Int> ids(passengers.begin(), passengers.end());
+		PacketWriter packet((Int)ServerPlayPacket::SetPassengers);
+		packet.writeVarInt(vehicleID);
+		packet.writeVarInt((Int)ids.size());
+		packet.writeVarInts(ids.data(), ids.size());
+
+		// Send the packet
+		sendPacket(client, packet);
 	}
 
 	template <class T> // Any IEnumerable like vector<String>
@@ -248,12 +449,24 @@ public:
 
 	}
 
-	NetworkHandler(EventHandler* eventHandler = NULL);
+	NetworkHandler(EventHandler* eventHandler = NULL, NetworkBackend backend = NetworkBackend::Default, Int numThreads = 0);
 	~NetworkHandler();
+	Boolean listenForClients(Int port);
 	void addClient(SOCKET& newClient);
-	void disconnectClient(Client* client);
+	void disconnectClient(Client* client); // From any thread, the client's network thread finishes the job
+	void flushClient(Client* client);
+	void flushClients();
+	Int streamChunks(std::chrono::steady_clock::time_point deadline);
+	void runInbound();
 	Client* getClientFromSocket(SOCKET& socket);
 	void start();
 	void startAsync();
 	void stop();
+	NetworkBackend getBackend() { return backend; }
+	Int getNumThreads() { return (Int)threads.size(); }
+	void setCompression(Int threshold, Int level = DEFAULT_COMPRESSION_LEVEL) { compressionThreshold = threshold; compressionLevel = level; }
+	Int getCompressionThreshold() { return compressionThreshold; }
+	Int getCompressionLevel() { return compressionLevel; }
+	PacketMetrics getPacketMetrics(ServerState state, Int packetID);
+	ServerStatus& getStatus() { return status; }
 };
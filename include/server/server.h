@@ -12,7 +12,7 @@
 	#pragma comment(lib, "Ws2_32.lib")
 #else		  // LINUX, POSIX, OSX
 	#include <sys/socket.h>
-	#include <arpa/net.h>
+	#include <arpa/inet.h>
 	#include <netdb.h>
 	#include <unistd.h>
 	typedef int SOCKET;
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "data/datatypes.h"
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <utility>
+
+// What the server list shows for the server's version
+#define STATUS_VERSION_NAME "1.12.2"
+#define STATUS_PROTOCOL_VERSION 340
+
+// The most players listed when hovering over the player count
+#define STATUS_MAX_SAMPLE 12
+
+/****************************************************************
+ * Server Status                                                *
+ * What the server shows in the server list. The Response       *
+ * packet is serialized whenever something in it changes, so    *
+ * that every ping after that just queues the same buffer up    *
+ * without touching the server thread                           *
+ ****************************************************************/
+class ServerStatus
+{
+protected:
+	std::mutex lock;
+	String motd;
+	String favicon;                                  // A 64x64 PNG in base64, or empty for none
+	Int maxPlayers;
+	std::vector< std::pair<String, String> > players; // The name and UUID of everyone that's playing
+	std::shared_ptr<const String> response;           // The finished Response packet
+	void rebuild();
+public:
+	ServerStatus(String motd = "A Bare Bones Minecraft Server", Int maxPlayers = 8);
+	void setMotd(String motd);
+	void setFavicon(String favicon);
+	void setMaxPlayers(Int maxPlayers);
+	void addPlayer(String name, String uuid);
+	void removePlayer(String uuid);
+	std::shared_ptr<const String> getResponse();
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "data/datatypes.h"
+#include <mutex>
+#include <vector>
+
+// How many of the latest ticks the averages and the histogram cover (5 seconds at 20 TPS)
+#define TICK_METRICS_WINDOW 100
+
+// The histogram has one bucket per millisecond, with everything slower in the last one
+#define TICK_HISTOGRAM_BUCKETS 128
+
+/******************************************************************
+ * Tick Metrics                                                   *
+ * Keeps track of how long the latest ticks took (MSPT), how many *
+ * of them ran per second (TPS) and a histogram of their lengths. *
+ * The tick clock records into it and anyone can query it while   *
+ * the server is running                                          *
+ ******************************************************************/
+class TickMetrics
+{
+protected:
+	struct Sample
+	{
+		Double start; // When the tick started, in seconds since the clock started
+		Double mspt;  // How long it took, in milliseconds
+	};
+	mutable std::mutex lock;
+	Sample samples[TICK_METRICS_WINDOW]; // The latest ticks, oldest first starting at next
+	Int next;
+	Int count;
+	Long buckets[TICK_HISTOGRAM_BUCKETS]; // The histogram of the ticks in the window
+	Double totalMSPT;                     // Sum of the ticks in the window
+	Double peakMSPT;                      // The longest tick ever
+	Long ticks;
+	Long skipped;
+	static Int toBucket(Double mspt);
+public:
+	TickMetrics();
+
+	/* Adds a tick that started at start (in seconds) and ran for mspt milliseconds, after skipping some */
+	void record(Double start, Double mspt, Int ticksSkipped = 0);
+
+	/* Average milliseconds per tick over the window */
+	Double getMSPT() const;
+
+	/* Ticks that started per second over the window */
+	Double getTPS() const;
+
+	/* How long (at most) the given fraction of the ticks in the window took, in milliseconds */
+	Double getPercentile(Double fraction) const;
+
+	/* Copies out the histogram of the window, bucket i counting ticks of [i, i + 1) milliseconds */
+	void getHistogram(std::vector<Long>& histogram) const;
+
+	Double getPeakMSPT() const;
+	Long getTickCount() const;
+	Long getSkippedTicks() const;
+	void reset();
+};
@@ -8,7 +8,7 @@ using namespace std;
  * Client :: Client    *
  * Default constructor *
  ***********************/
-Client::Client(SOCKET newClient) : socket(newClient), state(ServerState::Handshaking)
+Client::Client(SOCKET newClient) : socket(newClient), state(ServerState::Handshaking), ticksCongested(0), compressionThreshold(-1), networkThread(NULL)
 {
 	// Calculate the name
 	std::stringstream ss;
@@ -145,6 +145,27 @@ const Int& Client::getTicksSinceUpdate()
 	return ticksSinceUpdate;
 }
 
+/*******************************************************************
+ * Client :: getTicksCongested                                     *
+ * How many ticks in a row the client had too much left to receive *
+ *******************************************************************/
+const Int& Client::getTicksCongested()
+{
+	lock_guard<mutex> lock(dataLock);
+	return ticksCongested;
+}
+
+/***************************************************
+ * Client :: getCompressionThreshold               *
+ * Packets at least this big are compressed        *
+ * (negative if compression is off)                *
+ ***************************************************/
+const Int& Client::getCompressionThreshold()
+{
+	lock_guard<mutex> lock(dataLock);
+	return compressionThreshold;
+}
+
 /***********************************************************
  * Client :: getProtocolVersion                            *
  * The version of the network protocol the client is using *
@@ -385,6 +406,38 @@ Int Client::incrementTicksSinceUpdate(Int ticks)
 	return ticksSinceUpdate += ticks;
 }
 
+/*******************************************************************
+ * Client :: resetTicksCongested                                   *
+ * The client caught up on everything it was sent                  *
+ *******************************************************************/
+void Client::resetTicksCongested()
+{
+	lock_guard<mutex> lock(dataLock);
+	ticksCongested = 0;
+}
+
+/*******************************************************************
+ * Client :: incrementTicksCongested                               *
+ * Increment how many ticks in a row the client had too much left  *
+ * to receive                                                      *
+ *******************************************************************/
+Int Client::incrementTicksCongested(Int ticks)
+{
+	lock_guard<mutex> lock(dataLock);
+	return ticksCongested += ticks;
+}
+
+/*****************************************************
+ * Client :: setCompressionThreshold                 *
+ * Compress every packet at least this big from now  *
+ * on (negative turns compression off)               *
+ *****************************************************/
+void Client::setCompressionThreshold(Int threshold)
+{
+	lock_guard<mutex> lock(dataLock);
+	compressionThreshold = threshold;
+}
+
 /*******************************************************
  * Client :: setProtocolVersion                        *
  * Change the version of the client's network protocol *
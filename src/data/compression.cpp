@@ -0,0 +1,104 @@
+#include "debug.h"
+
+// zlib has its own (unsigned) Byte, keep it from clashing with ours
+#define Byte zlibByte
+#include <zlib.h>
+#undef Byte
+
+#include "data/compression.h"
+#include <cstring>
+
+/*************************************************
+ * ZlibStreams                                   *
+ * The zlib streams a thread reuses for every    *
+ * packet so that none of them pay for an init   *
+ *************************************************/
+struct ZlibStreams
+{
+	z_stream deflater;
+	z_stream inflater;
+	Boolean deflaterReady;
+	Boolean inflaterReady;
+	Int level; // The level the deflater is set to
+
+	ZlibStreams() : deflaterReady(false), inflaterReady(false), level(Z_DEFAULT_COMPRESSION)
+	{
+		memset(&deflater, 0, sizeof(deflater));
+		memset(&inflater, 0, sizeof(inflater));
+	}
+
+	~ZlibStreams()
+	{
+		if (deflaterReady)
+			deflateEnd(&deflater);
+		if (inflaterReady)
+			inflateEnd(&inflater);
+	}
+};
+
+thread_local ZlibStreams zlibStreams;
+
+/*************************************************
+ * deflateData                                   *
+ * Deflates the data and appends it to out       *
+ * Returns false if zlib failed                  *
+ *************************************************/
+Boolean deflateData(const char* data, size_t length, String& out, Int level)
+{
+	// Set up the thread's stream the first time, and only reset it after that
+	ZlibStreams& z = zlibStreams;
+	if (!z.deflaterReady)
+	{
+		if (deflateInit(&z.deflater, level) != Z_OK)
+			return false;
+		z.deflaterReady = true;
+		z.level = level;
+	}
+	else
+	{
+		deflateReset(&z.deflater);
+		if (z.level != level && deflateParams(&z.deflater, level, Z_DEFAULT_STRATEGY) == Z_OK)
+			z.level = level;
+	}
+
+	// Make room for the worst case and deflate everything in one go
+	size_t start = out.size();
+	out.resize(start + deflateBound(&z.deflater, (uLong)length));
+	z.deflater.next_in = (Bytef*)data;
+	z.deflater.avail_in = (uInt)length;
+	z.deflater.next_out = (Bytef*)&out[start];
+	z.deflater.avail_out = (uInt)(out.size() - start);
+	int ret = deflate(&z.deflater, Z_FINISH);
+
+	// Trim off the room that wasn't needed
+	out.resize(start + z.deflater.total_out);
+	return ret == Z_STREAM_END;
+}
+
+/*************************************************
+ * inflateData                                   *
+ * Inflates the data into out                    *
+ * Returns false if the data was corrupt or did  *
+ * not inflate to exactly outLength bytes        *
+ *************************************************/
+Boolean inflateData(const Byte* data, size_t length, Byte* out, size_t outLength)
+{
+	// Set up the thread's stream the first time, and only reset it after that
+	ZlibStreams& z = zlibStreams;
+	if (!z.inflaterReady)
+	{
+		if (inflateInit(&z.inflater) != Z_OK)
+			return false;
+		z.inflaterReady = true;
+	}
+	else
+		inflateReset(&z.inflater);
+
+	z.inflater.next_in = (Bytef*)data;
+	z.inflater.avail_in = (uInt)length;
+	z.inflater.next_out = (Bytef*)out;
+	z.inflater.avail_out = (uInt)outLength;
+	int ret = inflate(&z.inflater, Z_FINISH);
+
+	return ret == Z_STREAM_END && z.inflater.total_out == outLength;
+}
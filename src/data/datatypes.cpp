@@ -5,365 +5,19 @@
 #include <iostream>
 
 
-/******************************************
- * CountNumVarLength                      *
- * Reads a variable and counts its length *
- ******************************************/
-Byte CountNumVarLength(const Byte* data, const Byte maxlength)
-{
-	// Check for null data
-	if (data == NULL)
-		return 0;
-
-	// Parse the data byte by byte
-	Int numRead = 0;
-	Byte read;
-	do
-	{
-		// Read a byte of data
-		read = data[numRead];
-		numRead++;
-
-		// If we read too much data then throw an exception
-		if (numRead > maxlength)
-			throw new std::overflow_error("VarNum is too big");
-	} while ((read & 0x80) != 0); // Stop when we hit a certain number
-
-	return numRead;
-}
-
-/*******************************************
- * ParseNumVar                             *
- * Reads a variable of length x and throws *
- * an exception when that length is passed *
- *******************************************/
-Long parseNumVar(const Byte* data, const Byte maxlength)
-{
-	// Check for null data
-	if (data == NULL)
-		return 0;
-
-	// Parse the data byte by byte
-	Int numRead = 0;
-	Long result = 0;
-	Byte read;
-	do
-	{
-		// Read a byte of data
-		read = data[numRead];
-		result |= ((read & 0x7f) << (7 * numRead));
-		numRead++;
-
-		// If we read too much data then throw an exception
-		if (numRead > maxlength)
-			throw new std::overflow_error("VarNum is too big");
-	} while ((read & 0x80) != 0); // Stop when we hit a certain number
-
-	return result;
-}
-
-/*******************************************************
- * MakeNumVar                                          *
- * Takes a long and creates a variable of length x     *
- * It throws an exception if the new value is too long *
- *******************************************************/
-void makeNumVar(Long value, const Byte maxlength, VarNum& num)
-{
-	// Allocate some memory for the value
-	Byte* data = new Byte[maxlength];
-	Byte numWrote = 0;
-
-	do
-	{
-		// Calculate a byte
-		Byte temp = (Byte)(value & 0x7f);
-		value = (Long)(((ULong)value) >> 7); // Logical right-shift
-		if (value != 0)
-			temp |= 0x80;
-
-		// Write the calculated byte
-		data[numWrote++] = temp;
-
-		// Check if we exceeded the array
-		if (numWrote >= maxlength)
-			throw new std::overflow_error("VarNum is too big");
-
-		// Write the null byte at the end
-//		data[numWrote] = 0;
-	} while (value != 0);
-
-	// Assemble and return the VarNum
-	num.data = data;
-	num.length = CountNumVarLength(data, maxlength);
-}
-
-/*******************************************************
- * MakeNumVar                                          *
- * Takes an int and creates a variable of length x     *
- * It throws an exception if the new value is too long *
- *******************************************************/
-void makeNumVar(Int value, const Byte maxlength, VarNum& num)
-{
-	// Allocate some memory for the value
-	Byte* data = new Byte[maxlength];
-	Byte numWrote = 0;
-
-	do
-	{
-		// Calculate a byte
-		Byte temp = (Byte)(value & 0x7f);
-		value = (Int)(((UInt)value) >> 7); // Logical right-shift
-		if (value != 0)
-			temp |= 0x80;
-
-		// Write the calculated byte
-		data[numWrote++] = temp;
-
-		// Check if we exceeded the array
-		if (numWrote >= maxlength)
-			throw new std::overflow_error("VarInt is too big");
-
-		// Write the null byte at the end
-		data[numWrote] = 0;
-	} while (value != 0);
-
-	// Assemble and return the VarNum
-	num.data = data;
-	num.length = CountNumVarLength(data, maxlength);
-}
-
-/***********************
- * VarNum :: VarNum    *
- * Default Constructor *
- ***********************/
-VarNum::VarNum(Byte* data) : data(NULL)
-{
-	length = CountNumVarLength(data, VARNUM_MAX_SIZE);
-
-	// Copy the array given
-	Byte* newData = new Byte[length];
-	for (int i = 0; i < length; i++)
-		newData[i] = data[i];
-	this->data = newData;
-}
-
-/*********************
- * VarNum :: VarNum  *
- * Copy Constructor  *
- *********************/
-VarNum::VarNum(const VarNum& value)
-{
-	// If the other value has no data then forget about copying
-	if (value.data == NULL)
-	{
-		length = 0;
-		data = NULL;
-		return;
-	}
-
-	// Copy the data from the value to the new long
-	length = value.length;
-	data = new Byte[length];
-	for (int i = 0; i < length; i++)
-		data[i] = value.data[i];
-}
-
-/*********************
- * VarNum :: VarNum  *
- * Move Constructor  *
- *********************/
-VarNum::VarNum(VarNum&& value) : data(value.data), length(value.length)
-{
-	value.data = NULL;
-	value.length = 0;
-}
-
-/**************************
- * VarNum :: VarNum       *
- * Constructor from a Num *
- **************************/
-VarNum::VarNum(const Long value) { makeNumVar(value, VARNUM_MAX_SIZE, *this); }
-
-/**************************
- * VarNum :: VarNum       *
- * Constructor from a Num *
- **************************/
-VarNum::VarNum(const Int value) { makeNumVar(value, VARNUM_MAX_SIZE, *this); }
-
-/*********************
- * VarNum :: ~VarNum *
- * Destructor        *
- *********************/
-VarNum::~VarNum() { if (data != NULL) { delete[] data; data = NULL; } }
-
-/**************************
- * VarNum :: toNum        *
- * Converts VarNum to Num *
- **************************/
-Long VarNum::toNum() const { return parseNumVar(data, length); }
-
-/*****************************
- * VarNum :: getSize         *
- * Returns the size in bytes *
- *****************************/
-const Byte VarNum::getSize() const { return length; }
-
-/**************************
- * VarNum :: getData      *
- * Returns the data array *
- **************************/
-const Byte* VarNum::getData() const { return data; }
-
-/***********************
- * VarInt :: VarInt    *
- * Default Constructor *
- ***********************/
-VarInt::VarInt(Byte* data) : VarNum(data)
-{
-	if (length > VARINT_MAX_SIZE)
-		throw new std::overflow_error("VarInt is too big");
-}
-
-/*********************
- * VarInt :: VarInt  *
- * Copy Constructor  *
- *********************/
-VarInt::VarInt(const VarInt& value) : VarNum(value)
-{
-	if (length > VARINT_MAX_SIZE)
-		throw new std::overflow_error("VarInt is too big");
-}
-
-/************************
- * VarInt :: VarInt     *
- * Constructor from Int *
- ************************/
-VarInt::VarInt(const Int value) : VarNum((const Int)value)
-{
-	if (length > VARINT_MAX_SIZE)
-		throw new std::overflow_error("VarInt is too big");
-}
-
 /****************************
  * VarInt :: VarInt         *
  * Constructor from VarLong *
  ****************************/
-VarInt::VarInt(const VarLong& value) : VarNum(value)
-{
-	if (length > VARINT_MAX_SIZE)
-		throw new std::overflow_error("VarInt is too big");
-}
-
-/****************************
- * VarInt :: operator=      *
- * Copy Assignment Operator *
- ****************************/
-VarInt& VarInt::operator=(const VarInt& right)
-{
-	// If the other value has no data then forget about copying
-	if (right.data == NULL)
-	{
-		length = 0;
-		data = NULL;
-		return *this;
-	}
-
-	// Copy the data from the value to the new long
-	length = right.length;
-	data = new Byte[length];
-	for (int i = 0; i < length; i++)
-		data[i] = right.data[i];
-
-	return *this;
-}
-
-/*********************
- * VarInt :: ~VarInt *
- * Destructor        *
- *********************/
-VarInt::~VarInt() {}
-
-/**************************
- * VarInt :: toInt        *
- * Converts VarInt to Int *
- **************************/
-Int VarInt::toInt() const { return (Int)toNum(); }
-
-/***********************
- * VarLong :: VarLong  *
- * Default Constructor *
- ***********************/
-VarLong::VarLong(Byte* data) : VarNum(data)
+VarInt::VarInt(const VarLong& value)
 {
-	if (length > VARLONG_MAX_SIZE)
-		throw new std::overflow_error("VarLong is too big");
+	// Only longs that fit in 32 bits can be converted
+	Long num = value.toLong();
+	if (((ULong)num >> 32) != 0)
+		throw std::overflow_error("VarInt is too big");
+	length = encode((Int)num, data);
 }
 
-/***********************
- * VarLong :: VarLong  *
- * Copy Constructor    *
- ***********************/
-VarLong::VarLong(const VarLong& value) : VarNum(value)
-{
-	if (length > VARLONG_MAX_SIZE)
-		throw new std::overflow_error("VarLong is too big");
-}
-
-/*************************
- * VarLong :: VarLong    *
- * Constructor from Long *
- *************************/
-VarLong::VarLong(const Long value) : VarNum((const Long)value)
-{
-	if (length > VARLONG_MAX_SIZE)
-		throw new std::overflow_error("VarLong is too big");
-}
-
-/***************************
- * VarLong :: VarLong      *
- * Constructor from VarInt *
- ***************************/
-VarLong::VarLong(const VarInt& value) : VarNum(value)
-{
-	if (length > VARLONG_MAX_SIZE)
-		throw new std::overflow_error("VarLong is too big");
-}
-
-/***********************
- * VarLong :: ~VarLong *
- * Destructor          *
- ***********************/
-VarLong::~VarLong() {}
-
-/****************************
- * VarLong :: operator=     *
- * Copy Assignment Operator *
- ****************************/
-VarLong& VarLong::operator=(const VarLong& right)
-{
-	// If the other value has no data then forget about copying
-	if (right.data == NULL)
-	{
-		length = 0;
-		data = NULL;
-		return *this;
-	}
-
-	// Copy the data from the value to the new long
-	length = right.length;
-	data = new Byte[length];
-	for (int i = 0; i < length; i++)
-		data[i] = right.data[i];
-
-	return *this;
-}
-
-/****************************
- * VarLong :: toLong        *
- * Converts VarLong to Long *
- ****************************/
-Long VarLong::toLong() const { return toNum(); }
-
 /*********************************
  * SerialString :: SerialString  *
  * Default Constructor           *
@@ -380,8 +34,7 @@ SerialString::SerialString(Byte* data) : length(0), data(NULL)
 		// Copy the string to a new buffer
 		Int len = length.toInt();
 		this->data = new Byte[len];
-		for (int i = 0; i < len; i++)
-			this->data[i] = data[i];
+		memcpy(this->data, data, len);
 	}
 }
 
@@ -395,8 +48,7 @@ SerialString::SerialString(const String& text)
 	data = new Byte[text.length()];
 
 	// Copy the data from the string to this one
-	for (UInt i = 0; i < text.length(); i++)
-		data[i] = text[i];
+	memcpy(data, text.data(), text.length());
 }
 
 /*********************************
@@ -411,8 +63,7 @@ SerialString::SerialString(const SerialString& str)
 	length = VarInt(len);
 
 	// Copy the data
-	for (int i = 0; i < len; ++i)
-		data[i] = str.data[i];
+	memcpy(data, str.data, len);
 }
 
 /**********************************
@@ -427,8 +78,7 @@ SerialString& SerialString::operator=(const SerialString& rhs)
 	length = VarInt(len);
 
 	// Copy the data
-	for (int i = 0; i < len; ++i)
-		data[i] = rhs.data[i];
+	memcpy(data, rhs.data, len);
 
 	return *this;
 }
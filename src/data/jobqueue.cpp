@@ -1,4 +1,146 @@
 #include "data/jobqueue.h"
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <Windows.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "Synchronization.lib")
+#endif
+#else
+#include <chrono>
+#endif
+
+/*
+ * The queue is Dmitry Vyukov's intrusive MPSC queue: a producer swaps its node in as
+ * the new head and then links the old head to it, so pushing is one exchange and one
+ * store. The consumer follows the links from the tail. A producer that was swapped in
+ * but hasn't linked its node yet briefly hides everything behind it, which is why the
+ * count is kept separately and the consumer spins on it instead of going to sleep.
+ *
+ * The consumer sleeps on the wakeups counter with a futex (WaitOnAddress on Windows)
+ * and producers only bump it and make the system call when it says it's sleeping.
+ */
+
+/**************************************************
+ * waitOnAddress                                  *
+ * Sleeps until the value isn't expected anymore  *
+ * (or just for a moment, it can wake up early)   *
+ **************************************************/
+void waitOnAddress(std::atomic<unsigned>& value, unsigned expected)
+{
+	static_assert(sizeof(std::atomic<unsigned>) == sizeof(unsigned), "The futex needs a plain unsigned");
+#if defined(__linux__)
+	syscall(SYS_futex, (unsigned*)&value, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+#elif defined(_WIN32)
+	WaitOnAddress((volatile VOID*)&value, &expected, sizeof(expected), INFINITE);
+#else
+	if (value.load() == expected)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+}
+
+/**************************************************
+ * wakeAddress                                    *
+ * Wakes whoever is waiting on the value          *
+ **************************************************/
+void wakeAddress(std::atomic<unsigned>& value)
+{
+#if defined(__linux__)
+	syscall(SYS_futex, (unsigned*)&value, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#elif defined(_WIN32)
+	WakeByAddressSingle((PVOID)&value);
+#endif
+}
+
+/**************************
+ * Job Queue :: Job Queue *
+ * Default Constructor    *
+ **************************/
+JobQueue::JobQueue() : head(&stub), tail(&stub), count(0), wakeups(0), sleeping(false), running(false)
+{
+	stub.next.store(NULL);
+}
+
+/***************************
+ * Job Queue :: ~Job Queue *
+ * Destructor              *
+ ***************************/
+JobQueue::~JobQueue()
+{
+	stop();
+	if (jobThread.joinable())
+		jobThread.join();
+
+	// Throw away the jobs that never ran
+	while (Node* node = pop())
+		delete node;
+}
+
+/**********************************************
+ * Job Queue :: link                          *
+ * Adds the node to the head of the queue     *
+ **********************************************/
+void JobQueue::link(Node* node)
+{
+	node->next.store(NULL, std::memory_order_relaxed);
+	Node* previous = head.exchange(node, std::memory_order_acq_rel);
+	previous->next.store(node, std::memory_order_release);
+}
+
+/**********************************************
+ * Job Queue :: pop                           *
+ * Takes the next node off of the queue, or   *
+ * NULL if there isn't one (yet)              *
+ **********************************************/
+JobQueue::Node* JobQueue::pop()
+{
+	// Step past the stub
+	Node* node = tail;
+	Node* next = node->next.load(std::memory_order_acquire);
+	if (node == &stub)
+	{
+		if (next == NULL)
+			return NULL;
+		tail = next;
+		node = next;
+		next = next->next.load(std::memory_order_acquire);
+	}
+
+	// Anything that isn't the last node can be taken
+	if (next != NULL)
+	{
+		tail = next;
+		return node;
+	}
+
+	// The last node can only go once the stub is behind it, unless a producer is still linking it
+	if (node != head.load(std::memory_order_acquire))
+		return NULL;
+	link(&stub);
+	next = node->next.load(std::memory_order_acquire);
+	if (next != NULL)
+	{
+		tail = next;
+		return node;
+	}
+	return NULL;
+}
+
+/**********************************************
+ * Job Queue :: wake                          *
+ * Wakes the thread running the jobs if it's  *
+ * asleep                                     *
+ **********************************************/
+void JobQueue::wake()
+{
+	if (sleeping.load())
+	{
+		wakeups.fetch_add(1);
+		wakeAddress(wakeups);
+	}
+}
 
 /*********************************
  * Job Queue :: executeJobs      *
@@ -9,28 +151,34 @@
 bool JobQueue::executeJobs(bool waitForJobs)
 {
 	// Run all of the jobs in the queue
-	std::unique_lock<std::mutex> lock(queueLock);
-	while (jobQueue.size() && running.load())
+	while (running.load())
 	{
-		// Get the job and pop it off of the queue
-		const std::function<void()> func = jobQueue.front();
-		jobQueue.pop();
-
-		// Unlock the mutex and run the job
-		lock.unlock();
-		func();
-		
-		// Lock the mutex again to check for more jobs
-		lock.lock();
-	}
+		Node* node = pop();
+		if (node != NULL)
+		{
+			count.fetch_sub(1);
+			Job job = std::move(node->job);
+			delete node;
+			job();
+			continue;
+		}
 
-	// Unlock the mutex after viewing the queue's size
-	lock.unlock();
+		// A producer is halfway through pushing its job, it'll be linked in a moment
+		if (count.load() > 0)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		if (!waitForJobs)
+			break;
 
-	// If we're waiting for another job then sleep
-	if (waitForJobs && running.load())
-	{
-		// TODO: Use a condition to wake up if a job is added to the queue
+		// Sleep until a job is pushed (or the queue is stopped). The wakeups have to be
+		// read before checking for jobs so that a push in between isn't missed
+		sleeping.store(true);
+		unsigned epoch = wakeups.load();
+		if (count.load() == 0 && running.load())
+			waitOnAddress(wakeups, epoch);
+		sleeping.store(false);
 	}
 
 	// Make sure we stop and return whether we stopped prematurely or finished all jobs
@@ -45,6 +193,10 @@ bool JobQueue::executeJobs(bool waitForJobs)
  **********************************************************************************/
 bool JobQueue::start(bool runAsync)
 {
+	// A thread left over from being started before has to finish first
+	if (runAsync && !running.load() && jobThread.joinable())
+		jobThread.join();
+
 	// If the job queue is not already running then start
 	if (!running.exchange(true))
 	{
@@ -59,22 +211,113 @@ bool JobQueue::start(bool runAsync)
 	return true;
 }
 
-/*********************************
- * Job Queue :: size             *
- * Returns the size of the queue *
- *********************************/
-int JobQueue::size()
+/****************************************
+ * Job Queue :: runOne                  *
+ * Runs the next job if there is one,   *
+ * from the thread that runs the jobs   *
+ ****************************************/
+bool JobQueue::runOne()
 {
-	std::lock_guard<std::mutex> lock(queueLock);
-	return jobQueue.size();
+	Node* node = pop();
+	if (node == NULL)
+		return false;
+	count.fetch_sub(1);
+	Job job = std::move(node->job);
+	delete node;
+	job();
+	return true;
 }
 
 /****************************************
- * Job Queue :: start                   *
- * Starts executing jobs from the queue *
+ * Job Queue :: push                    *
+ * Adds a job to the end of the queue   *
  ****************************************/
-void JobQueue::push(const std::function<void()> job)
+void JobQueue::push(Job job)
+{
+	// Count the job first so that the thread running them never goes to sleep while it's being linked
+	Node* node = new Node();
+	node->job = std::move(job);
+	count.fetch_add(1);
+	link(node);
+	wake();
+}
+
+/********************************************
+ * Priority Job Queue :: Priority Job Queue *
+ * Default Constructor                      *
+ ********************************************/
+PriorityJobQueue::PriorityJobQueue()
+{
+	for (int i = 0; i < JOB_PRIORITIES; ++i)
+		passedOver[i] = 0;
+}
+
+/********************************************
+ * Priority Job Queue :: size               *
+ * How many jobs are waiting in every lane  *
+ ********************************************/
+int PriorityJobQueue::size()
+{
+	int total = 0;
+	for (int i = 0; i < JOB_PRIORITIES; ++i)
+		total += lanes[i].size();
+	return total;
+}
+
+/**********************************************
+ * Priority Job Queue :: pick                 *
+ * Picks the lane the next job comes from, or *
+ * -1 if they're all empty                    *
+ **********************************************/
+int PriorityJobQueue::pick(JobPriority lowest)
 {
-	std::lock_guard<std::mutex> lock(queueLock);
-	jobQueue.push(job);
+	// The most urgent lane goes, unless one behind it has run out of patience
+	int lane = -1;
+	for (int i = 0; i <= (int)lowest; ++i)
+	{
+		if (lanes[i].empty())
+			continue;
+		if (lane < 0)
+			lane = i;
+		else if (passedOver[i] >= JOB_LANE_PATIENCE)
+		{
+			lane = i;
+			break;
+		}
+	}
+
+	// Everyone behind it (with jobs waiting) was passed over once more
+	if (lane >= 0)
+	{
+		passedOver[lane] = 0;
+		for (int i = lane + 1; i <= (int)lowest; ++i)
+			if (!lanes[i].empty())
+				passedOver[i]++;
+	}
+	return lane;
+}
+
+/**********************************************
+ * Priority Job Queue :: run                  *
+ * Runs jobs in priority order until they're  *
+ * done or the deadline passes                *
+ * Returns how many jobs ran                  *
+ **********************************************/
+int PriorityJobQueue::run(JobPriority lowest, std::chrono::steady_clock::time_point deadline)
+{
+	int ran = 0;
+	bool timed = deadline != std::chrono::steady_clock::time_point::max();
+	for (int lane = pick(lowest); lane >= 0; lane = pick(lowest))
+	{
+		// A producer is halfway through pushing its job, it'll be linked in a moment
+		if (!lanes[lane].runOne())
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		ran++;
+		if (timed && std::chrono::steady_clock::now() >= deadline)
+			break;
+	}
+	return ran;
 }
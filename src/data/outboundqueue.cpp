@@ -0,0 +1,256 @@
+#include "debug.h"
+#include "data/outboundqueue.h"
+#include <utility>
+
+/**************************************************
+ * Outbound Queue :: Push                         *
+ * Copies a packet to the back of the queue,      *
+ * packing it in with the packets before it       *
+ **************************************************/
+void OutboundQueue::push(const char* data, size_t length)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	if (closed)
+		return;
+
+	// Start a new buffer if the last one is full or isn't ours to write to yet
+	if (buffers.empty() || buffers.back().pending || buffers.back().shared || buffers.back().data.size() + length > OUTBOUND_CHUNK_SIZE)
+	{
+		buffers.push_back(OutboundBuffer());
+		buffers.back().data.reserve(length > OUTBOUND_CHUNK_SIZE ? length : OUTBOUND_CHUNK_SIZE);
+	}
+
+	buffers.back().data.append(data, length);
+	queued += length;
+}
+
+/****************************************************
+ * Outbound Queue :: Push                           *
+ * Moves a packet to the back of the queue. Big     *
+ * packets keep their own buffer instead of copying *
+ ****************************************************/
+void OutboundQueue::push(String&& data)
+{
+	// Small packets are cheaper to pack together
+	if (data.size() < OUTBOUND_CHUNK_SIZE / 2)
+	{
+		push(data.data(), data.size());
+		return;
+	}
+
+	std::lock_guard<std::mutex> guard(lock);
+	if (closed)
+		return;
+	queued += data.size();
+	buffers.push_back(OutboundBuffer());
+	buffers.back().data = std::move(data);
+}
+
+/*****************************************************
+ * Outbound Queue :: Push                            *
+ * Adds a packet that's being sent to other clients  *
+ * too to the back of the queue. Big packets are     *
+ * shared between the queues instead of copied       *
+ *****************************************************/
+void OutboundQueue::push(const std::shared_ptr<const String>& data)
+{
+	// Small packets are cheaper to pack together
+	if (data->size() < OUTBOUND_CHUNK_SIZE / 2)
+	{
+		push(data->data(), data->size());
+		return;
+	}
+
+	std::lock_guard<std::mutex> guard(lock);
+	if (closed)
+		return;
+	queued += data->size();
+	buffers.push_back(OutboundBuffer());
+	buffers.back().shared = data;
+}
+
+/*******************************************************
+ * Outbound Queue :: Push Pending                      *
+ * Saves a spot at the back of the queue for a packet  *
+ * that another thread is still working on. Whatever   *
+ * gets queued after it waits until it's marked ready  *
+ *******************************************************/
+std::shared_ptr<OutboundPending> OutboundQueue::pushPending(size_t estimate)
+{
+	std::shared_ptr<OutboundPending> pending = std::make_shared<OutboundPending>();
+	pushPending(pending, estimate);
+	return pending;
+}
+
+void OutboundQueue::pushPending(const std::shared_ptr<OutboundPending>& pending, size_t estimate)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	if (closed)
+		return;
+	buffers.push_back(OutboundBuffer());
+	buffers.back().pending = pending;
+	buffers.back().estimate = estimate;
+	queued += estimate;
+}
+
+/******************************************************
+ * Outbound Queue :: Is Ready                         *
+ * Whether the buffer can be written, picking up its  *
+ * data if it was pending and has just become ready   *
+ ******************************************************/
+Boolean OutboundQueue::isReady(OutboundBuffer& buffer)
+{
+	if (!buffer.pending)
+		return true;
+	if (!buffer.pending->ready.load(std::memory_order_acquire))
+		return false;
+
+	// Swap the guess for the real size (the data may be shared with other queues, so it's only referenced)
+	buffer.shared = buffer.pending->data;
+	buffer.pending.reset();
+	queued = queued - buffer.estimate + buffer.shared->size();
+	return true;
+}
+
+/***************************************
+ * Outbound Queue :: Size              *
+ * Returns how many bytes are waiting  *
+ ***************************************/
+size_t OutboundQueue::size()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return queued;
+}
+
+/**********************************************************
+ * Outbound Queue :: Get Slices                           *
+ * Fills in the pieces at the front of the queue that are *
+ * ready and returns how many there were (at most         *
+ * maxSlices). They stay valid until the queue is changed *
+ **********************************************************/
+Int OutboundQueue::getSlices(OutboundSlice* slices, Int maxSlices)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return getSlicesUnlocked(slices, maxSlices);
+}
+
+Int OutboundQueue::getSlicesUnlocked(OutboundSlice* slices, Int maxSlices)
+{
+	Int count = 0;
+	for (std::deque<OutboundBuffer>::iterator it = buffers.begin(); it != buffers.end() && count < maxSlices && isReady(*it); ++it, ++count)
+	{
+		size_t offset = count == 0 ? frontOffset : 0;
+		slices[count].data = it->getData().data() + offset;
+		slices[count].length = it->getData().size() - offset;
+	}
+
+	return count;
+}
+
+/******************************************************
+ * Outbound Queue :: Consume                          *
+ * Drops count bytes that were written from the front *
+ ******************************************************/
+void OutboundQueue::consume(size_t count)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	consumeUnlocked(count);
+}
+
+void OutboundQueue::consumeUnlocked(size_t count)
+{
+	queued -= count;
+	count += frontOffset;
+
+	// Drop every buffer that was written completely
+	while (!buffers.empty() && !buffers.front().pending && count >= buffers.front().getData().size())
+	{
+		count -= buffers.front().getData().size();
+		buffers.pop_front();
+	}
+
+	frontOffset = count;
+}
+
+/**************************************
+ * Outbound Queue :: Clear            *
+ * Drops everything that's waiting    *
+ **************************************/
+void OutboundQueue::clear()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	buffers.clear();
+	queued = 0;
+	frontOffset = 0;
+}
+
+/*****************************************************
+ * Outbound Queue :: Close                           *
+ * Drops everything that's waiting and stops taking  *
+ * packets. Whoever is in the middle of writing the  *
+ * queue is waited on, so the socket can be closed   *
+ * once this returns without anyone still using it.  *
+ * Returns false if it was already closed            *
+ *****************************************************/
+Boolean OutboundQueue::close()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	buffers.clear();
+	queued = 0;
+	frontOffset = 0;
+	return !std::exchange(closed, true);
+}
+
+/*****************************************************
+ * Outbound Queue :: Is Closed                       *
+ * Whether the queue stopped taking packets          *
+ *****************************************************/
+Boolean OutboundQueue::isClosed()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return closed;
+}
+
+/*****************************************************
+ * Outbound Queue :: Swap                            *
+ * Trades contents with another queue atomically     *
+ *****************************************************/
+void OutboundQueue::swap(OutboundQueue& rhs)
+{
+	std::lock(lock, rhs.lock);
+	std::lock_guard<std::mutex> guard1(lock, std::adopt_lock);
+	std::lock_guard<std::mutex> guard2(rhs.lock, std::adopt_lock);
+	buffers.swap(rhs.buffers);
+	std::swap(queued, rhs.queued);
+	std::swap(frontOffset, rhs.frontOffset);
+}
+
+/*******************************************************
+ * Outbound Queue :: Move Ready To                     *
+ * Moves everything at the front that's ready to be    *
+ * written onto the back of another queue, leaving the *
+ * pending packets (and whatever is behind them) here  *
+ *******************************************************/
+void OutboundQueue::moveReadyTo(OutboundQueue& rhs)
+{
+	std::lock(lock, rhs.lock);
+	std::lock_guard<std::mutex> guard1(lock, std::adopt_lock);
+	std::lock_guard<std::mutex> guard2(rhs.lock, std::adopt_lock);
+
+	// A partly written buffer can only go to an empty queue, which can keep track of how much of it is left
+	if (frontOffset > 0 && !rhs.buffers.empty())
+		return;
+
+	while (!buffers.empty() && isReady(buffers.front()))
+	{
+		size_t size = buffers.front().getData().size() - frontOffset;
+		if (rhs.buffers.empty())
+			rhs.frontOffset = frontOffset;
+		frontOffset = 0;
+
+		rhs.buffers.push_back(std::move(buffers.front()));
+		buffers.pop_front();
+		queued -= size;
+		rhs.queued += size;
+	}
+}
@@ -0,0 +1,90 @@
+#include "debug.h"
+#include "data/packetreader.h"
+#include "data/varintbatch.h"
+#include "data/utf8.h"
+
+/**************************************************
+ * Packet Reader :: Read Var Int                  *
+ * Reads a VarInt of at most 5 bytes              *
+ **************************************************/
+Int PacketReader::readVarInt()
+{
+	UInt value = 0;
+	for (Int i = 0; i < 5; i++)
+	{
+		const Byte* byte = take(1);
+		if (!byte)
+			return 0;
+		value |= (UInt)(*byte & 0x7F) << (7 * i);
+		if (!(*byte & 0x80))
+			return (Int)value;
+	}
+
+	// Anything longer than 5 bytes isn't a VarInt
+	failed = true;
+	return 0;
+}
+
+/**************************************************
+ * Packet Reader :: Read Var Long                 *
+ * Reads a VarLong of at most 10 bytes            *
+ **************************************************/
+Long PacketReader::readVarLong()
+{
+	ULong value = 0;
+	for (Int i = 0; i < 10; i++)
+	{
+		const Byte* byte = take(1);
+		if (!byte)
+			return 0;
+		value |= (ULong)(*byte & 0x7F) << (7 * i);
+		if (!(*byte & 0x80))
+			return (Long)value;
+	}
+
+	// Anything longer than 10 bytes isn't a VarLong
+	failed = true;
+	return 0;
+}
+
+/**************************************************
+ * Packet Reader :: Read Var Ints                 *
+ * Reads count VarInts into out all at once       *
+ **************************************************/
+void PacketReader::readVarInts(Int* out, size_t count)
+{
+	Long size = failed ? -1 : decodeVarInts(data, (size_t)(end - data), out, count);
+	if (size < 0)
+	{
+		failed = true;
+		memset(out, 0, count * sizeof(Int));
+		return;
+	}
+	data += size;
+}
+
+/**************************************************
+ * Packet Reader :: Read String View              *
+ * Reads a string that's prefixed by its length,  *
+ * leaving it where it is in the packet. Fails if *
+ * it isn't UTF-8 or has more than maxLength      *
+ * characters                                     *
+ **************************************************/
+StringView PacketReader::readStringView(Int maxLength)
+{
+	// No character takes more than 4 bytes
+	Int length = readVarInt();
+	if (length < 0 || length > maxLength * 4)
+		failed = true;
+	const Byte* bytes = failed ? NULL : take((size_t)length);
+	if (!bytes)
+		return StringView();
+
+	Int characters = validateUtf8(bytes, (size_t)length);
+	if (characters < 0 || characters > maxLength)
+	{
+		failed = true;
+		return StringView();
+	}
+	return StringView((const char*)bytes, (size_t)length);
+}
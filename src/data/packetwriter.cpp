@@ -0,0 +1,62 @@
+#include "debug.h"
+#include "data/packetwriter.h"
+#include "data/varintbatch.h"
+
+// Every thread writes its packets into the same buffer, which only ever grows
+thread_local String packetWriterBuffer;
+
+/**************************************************
+ * Packet Writer :: Packet Writer                 *
+ * Starts a packet in the thread's buffer with    *
+ * room for its header followed by its id         *
+ **************************************************/
+PacketWriter::PacketWriter(Int packetID) : buffer(packetWriterBuffer), start(0)
+{
+	buffer.assign(PACKETWRITER_HEADER_SIZE, '\0');
+	writeVarInt(packetID);
+}
+
+/**************************************************
+ * Packet Writer :: Write Var Long                *
+ * Writes a 64-bit number as a VarLong            *
+ **************************************************/
+void PacketWriter::writeVarLong(Long value)
+{
+	Byte data[VARLONG_MAX_SIZE];
+	buffer.append((const char*)data, VarLong::encode(value, data));
+}
+
+/**************************************************
+ * Packet Writer :: Write Var Ints                *
+ * Writes a whole array of numbers as VarInts     *
+ **************************************************/
+void PacketWriter::writeVarInts(const Int* values, size_t count)
+{
+	size_t size = buffer.size();
+	buffer.resize(size + count * VARINT_MAX_SIZE);
+	buffer.resize(size + encodeVarInts(values, count, (Byte*)&buffer[size]));
+}
+
+/******************************************************
+ * Packet Writer :: Finish                            *
+ * Fills in the header right up against the body so  *
+ * that the packet can be sent straight out of the    *
+ * buffer without moving it                           *
+ ******************************************************/
+void PacketWriter::finish(Boolean compressed)
+{
+	// With compression on, small packets say they weren't compressed by having an uncompressed length of zero
+	Int end = PACKETWRITER_HEADER_SIZE;
+	Int length = getBodySize();
+	if (compressed)
+	{
+		buffer[--end] = 0;
+		length++;
+	}
+
+	// Write the length where it ends right where the rest begins
+	char data[5];
+	Int size = encodeVarInt(data, (UInt)length);
+	start = end - size;
+	memcpy(&buffer[start], data, size);
+}
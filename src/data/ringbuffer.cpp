@@ -0,0 +1,122 @@
+#include "debug.h"
+#include "data/ringbuffer.h"
+#include <cstring>
+
+/*******************************************
+ * roundUpToPowerOfTwo                     *
+ * Returns the smallest power of two that  *
+ * is at least as big as the given number  *
+ *******************************************/
+Int roundUpToPowerOfTwo(Int num)
+{
+	Int result = 1;
+	while (result < num)
+		result <<= 1;
+	return result;
+}
+
+/***********************
+ * Ring Buffer         *
+ * Default Constructor *
+ ***********************/
+RingBuffer::RingBuffer(Int capacity) : data(NULL), capacity(0), head(0), length(0)
+{
+	if (capacity > 0)
+		resize(roundUpToPowerOfTwo(capacity));
+}
+
+/**********************************************
+ * Ring Buffer :: Resize                      *
+ * Moves the data into a buffer of a new size *
+ * The data always starts at the front after  *
+ **********************************************/
+void RingBuffer::resize(Int newCapacity)
+{
+	Byte* newData = newCapacity > 0 ? new Byte[newCapacity] : NULL;
+
+	// Copy the data over in (at most) two pieces
+	if (length > 0)
+	{
+		Int firstPart = capacity - head < length ? capacity - head : length;
+		memcpy(newData, data + head, firstPart);
+		memcpy(newData + firstPart, data, length - firstPart);
+	}
+
+	if (data)
+		delete[] data;
+	data = newData;
+	capacity = newCapacity;
+	head = 0;
+}
+
+/*******************************************************
+ * Ring Buffer :: Reserve                              *
+ * Makes sure the buffer can hold at least size bytes *
+ *******************************************************/
+void RingBuffer::reserve(Int size)
+{
+	if (size > capacity)
+		resize(roundUpToPowerOfTwo(size));
+}
+
+/**************************************
+ * Ring Buffer :: Append              *
+ * Copies bytes to the back of buffer *
+ **************************************/
+void RingBuffer::append(const Byte* bytes, Int count)
+{
+	// Make room for the new bytes
+	reserve(length + count);
+
+	// Copy the bytes over in (at most) two pieces
+	Int tail = (head + length) & (capacity - 1);
+	Int firstPart = capacity - tail < count ? capacity - tail : count;
+	memcpy(data + tail, bytes, firstPart);
+	memcpy(data, bytes + firstPart, count - firstPart);
+	length += count;
+}
+
+/******************************************************
+ * Ring Buffer :: Peek                                *
+ * Returns the first count bytes as one piece of      *
+ * memory. The bytes are only moved if they wrap      *
+ * around the end of the buffer. Passing a count      *
+ * bigger than the size causes undefined behavior!    *
+ ******************************************************/
+Byte* RingBuffer::peek(Int count)
+{
+	// If the bytes wrap around then straighten the buffer out first
+	if (head + count > capacity)
+		resize(capacity);
+
+	return data + head;
+}
+
+/*****************************************************
+ * Ring Buffer :: Consume                            *
+ * Drops count bytes from the front of the buffer    *
+ * (no more than it holds)                           *
+ *****************************************************/
+void RingBuffer::consume(Int count)
+{
+	if (count > length)
+		count = length;
+	head = (head + count) & (capacity - 1);
+	length -= count;
+
+	// Once the buffer is empty, start from the front again
+	if (length == 0)
+		clear();
+}
+
+/*******************************************************
+ * Ring Buffer :: Clear                                *
+ * Empties the buffer, freeing it if it grew too large *
+ *******************************************************/
+void RingBuffer::clear()
+{
+	head = 0;
+	length = 0;
+	if (capacity > RINGBUFFER_MAX_IDLE_CAPACITY)
+		resize(0);
+}
@@ -0,0 +1,288 @@
+#include "debug.h"
+#include "data/threadpool.h"
+
+// Which worker (and of which pool) the thread is, if it's one at all
+thread_local ThreadPool* currentPool = NULL;
+thread_local Int currentWorker = -1;
+
+/******************************************************
+ * Work Stealing Deque :: Work Stealing Deque         *
+ * Starts with room for size tasks (a power of two)   *
+ ******************************************************/
+WorkStealingDeque::WorkStealingDeque(Long size) : top(0), bottom(0), ring(new Ring(size)) {}
+
+/******************************************************
+ * Work Stealing Deque :: ~Work Stealing Deque        *
+ * Destructor                                         *
+ ******************************************************/
+WorkStealingDeque::~WorkStealingDeque()
+{
+	delete ring.load();
+	for (size_t i = 0; i < retired.size(); ++i)
+		delete retired[i];
+}
+
+/******************************************************
+ * Work Stealing Deque :: push                        *
+ * Adds a task to the bottom, doubling the ring if    *
+ * it's full                                          *
+ ******************************************************/
+void WorkStealingDeque::push(Task* task)
+{
+	Long b = bottom.load(std::memory_order_relaxed);
+	Long t = top.load(std::memory_order_acquire);
+	Ring* r = ring.load(std::memory_order_relaxed);
+	if (b - t > r->size - 1)
+	{
+		// Thieves may still be reading the old ring, so it sticks around until the deque goes
+		Ring* bigger = new Ring(r->size * 2);
+		for (Long i = t; i < b; ++i)
+			bigger->put(i, r->get(i));
+		retired.push_back(r);
+		ring.store(bigger, std::memory_order_release);
+		r = bigger;
+	}
+	r->put(b, task);
+	std::atomic_thread_fence(std::memory_order_release);
+	bottom.store(b + 1, std::memory_order_relaxed);
+}
+
+/******************************************************
+ * Work Stealing Deque :: take                        *
+ * Takes the newest task off of the bottom, racing    *
+ * the thieves for the last one                       *
+ ******************************************************/
+WorkStealingDeque::Task* WorkStealingDeque::take()
+{
+	Long b = bottom.load(std::memory_order_relaxed) - 1;
+	Ring* r = ring.load(std::memory_order_relaxed);
+	bottom.store(b, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	Long t = top.load(std::memory_order_relaxed);
+
+	// It was already empty
+	if (t > b)
+	{
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return NULL;
+	}
+
+	// Anything but the last task is ours, the last one goes to whoever moves the top first
+	Task* task = r->get(b);
+	if (t == b)
+	{
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			task = NULL;
+		bottom.store(b + 1, std::memory_order_relaxed);
+	}
+	return task;
+}
+
+/******************************************************
+ * Work Stealing Deque :: steal                       *
+ * Takes the oldest task off of the top, or NULL if   *
+ * it's empty or another thread got to it first       *
+ ******************************************************/
+WorkStealingDeque::Task* WorkStealingDeque::steal()
+{
+	Long t = top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	Long b = bottom.load(std::memory_order_acquire);
+	if (t >= b)
+		return NULL;
+
+	Task* task = ring.load(std::memory_order_acquire)->get(t);
+	if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		return NULL;
+	return task;
+}
+
+/**********************************************
+ * Thread Pool :: Thread Pool                 *
+ * Starts a worker for every core but the one *
+ * the server thread runs on, if no number    *
+ * was given                                  *
+ **********************************************/
+ThreadPool::ThreadPool(Int numWorkers) : queued(0), sleepers(0), running(true)
+{
+	if (numWorkers <= 0)
+		numWorkers = std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 1;
+
+	for (Int i = 0; i < numWorkers; ++i)
+		deques.push_back(new WorkStealingDeque());
+	for (Int i = 0; i < numWorkers; ++i)
+		workers.push_back(std::thread(&ThreadPool::work, this, i));
+}
+
+/**********************************************
+ * Thread Pool :: ~Thread Pool                *
+ * Destructor                                 *
+ **********************************************/
+ThreadPool::~ThreadPool()
+{
+	// Wake everyone up so that they notice we're done
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		running = false;
+	}
+	wakeup.notify_all();
+	for (size_t i = 0; i < workers.size(); ++i)
+		workers[i].join();
+
+	// Throw away whatever never ran
+	for (size_t i = 0; i < deques.size(); ++i)
+	{
+		while (Task* task = deques[i]->steal())
+			delete task;
+		delete deques[i];
+	}
+	for (size_t i = 0; i < injected.size(); ++i)
+		delete injected[i];
+}
+
+/**********************************************
+ * Thread Pool :: schedule                    *
+ * Puts the task on the worker's own deque,   *
+ * or the shared queue from any other thread, *
+ * and wakes up a worker to take it           *
+ **********************************************/
+void ThreadPool::schedule(Task* task)
+{
+	queued.fetch_add(1);
+	if (currentPool == this)
+		deques[currentWorker]->push(task);
+	else
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		injected.push_back(task);
+	}
+
+	// Only take the lock to wake someone if anyone is asleep
+	if (sleepers.load() > 0)
+	{
+		{ std::lock_guard<std::mutex> guard(lock); }
+		wakeup.notify_one();
+	}
+}
+
+/**********************************************
+ * Thread Pool :: run                         *
+ * Starts the task as part of the group       *
+ **********************************************/
+void ThreadPool::run(TaskGroup& group, Job job)
+{
+	group.pending.fetch_add(1, std::memory_order_relaxed);
+	schedule(new Task{ std::move(job), &group });
+}
+
+/**********************************************
+ * Thread Pool :: find                        *
+ * Finds a task for the worker (or -1 for     *
+ * any other thread): its own newest task,    *
+ * then the shared queue, then the oldest     *
+ * task of any of the other workers           *
+ **********************************************/
+ThreadPool::Task* ThreadPool::find(Int index)
+{
+	Task* task = NULL;
+	if (index >= 0)
+		task = deques[index]->take();
+
+	if (task == NULL)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		if (!injected.empty())
+		{
+			task = injected.front();
+			injected.pop_front();
+		}
+	}
+
+	// Start stealing from the next worker over so that they don't all go after the same one
+	for (size_t i = 1; task == NULL && i <= deques.size(); ++i)
+		task = deques[(index + i) % deques.size()]->steal();
+
+	if (task != NULL)
+		queued.fetch_sub(1);
+	return task;
+}
+
+/**********************************************
+ * Thread Pool :: findInGroup                 *
+ * Takes one of the group's tasks from the    *
+ * shared queue, or NULL if none are left     *
+ * there                                      *
+ **********************************************/
+ThreadPool::Task* ThreadPool::findInGroup(TaskGroup& group)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	for (std::deque<Task*>::iterator it = injected.begin(); it != injected.end(); ++it)
+	{
+		if ((*it)->group != &group)
+			continue;
+		Task* task = *it;
+		injected.erase(it);
+		queued.fetch_sub(1);
+		return task;
+	}
+	return NULL;
+}
+
+/**********************************************
+ * Thread Pool :: execute                     *
+ * Runs the task and marks it off its group   *
+ **********************************************/
+void ThreadPool::execute(Task* task)
+{
+	task->job();
+	if (task->group != NULL)
+		task->group->pending.fetch_sub(1, std::memory_order_release);
+	delete task;
+}
+
+/**********************************************
+ * Thread Pool :: work                        *
+ * Runs tasks until the pool is destroyed     *
+ **********************************************/
+void ThreadPool::work(Int index)
+{
+	currentPool = this;
+	currentWorker = index;
+	while (true)
+	{
+		Task* task = find(index);
+		if (task != NULL)
+		{
+			execute(task);
+			continue;
+		}
+
+		// Sleep until there's something to do. Counting ourselves as asleep before
+		// checking again means a task scheduled in between will wake us back up
+		std::unique_lock<std::mutex> guard(lock);
+		sleepers.fetch_add(1);
+		wakeup.wait(guard, [this]() { return queued.load() > 0 || !running; });
+		sleepers.fetch_sub(1);
+		if (!running)
+			return;
+	}
+}
+
+/**********************************************
+ * Thread Pool :: wait                        *
+ * Runs tasks until the group is done         *
+ **********************************************/
+void ThreadPool::wait(TaskGroup& group)
+{
+	// Workers help with anything, but other threads (like the server thread) only help with the
+	// group's own tasks so that they never get stuck running someone else's long job
+	Int index = currentPool == this ? currentWorker : -1;
+	while (!group.done())
+	{
+		Task* task = index >= 0 ? find(index) : findInGroup(group);
+		if (task != NULL)
+			execute(task);
+		else
+			std::this_thread::yield();
+	}
+}
@@ -0,0 +1,104 @@
+#include "debug.h"
+#include "data/utf8.h"
+#ifdef UTF8_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+/*
+ * Nearly all of what players type is ASCII, so 16 bytes are checked at once and
+ * skipped over when none of them have the top bit set. A block with anything
+ * else in it is walked one character at a time, and the next block starts
+ * wherever the last character in it ended.
+ */
+
+/*************************************************
+ * readUtf8Char                                  *
+ * Checks the character that starts at data[i]   *
+ * and moves i past it. Returns how many UTF-16  *
+ * units it counts as, or 0 if it's malformed    *
+ *************************************************/
+inline Int readUtf8Char(const UByte* data, size_t length, size_t& i)
+{
+	UByte lead = data[i];
+	if (lead < 0x80)
+	{
+		++i;
+		return 1;
+	}
+
+	// Work out how many bytes follow and which values the first of them can have,
+	// which rules out overlong encodings, surrogates, and anything past U+10FFFF
+	size_t size;
+	UByte low = 0x80, high = 0xBF;
+	if (lead < 0xC2)
+		return 0;
+	else if (lead < 0xE0)
+		size = 2;
+	else if (lead < 0xF0)
+	{
+		size = 3;
+		if (lead == 0xE0)
+			low = 0xA0;
+		else if (lead == 0xED)
+			high = 0x9F;
+	}
+	else if (lead < 0xF5)
+	{
+		size = 4;
+		if (lead == 0xF0)
+			low = 0x90;
+		else if (lead == 0xF4)
+			high = 0x8F;
+	}
+	else
+		return 0;
+
+	// Every byte after the lead has to be a continuation byte
+	if (length - i < size || data[i + 1] < low || data[i + 1] > high)
+		return 0;
+	for (size_t j = 2; j < size; ++j)
+		if ((data[i + j] & 0xC0) != 0x80)
+			return 0;
+	i += size;
+	return size == 4 ? 2 : 1;
+}
+
+Int validateUtf8(const Byte* data, size_t length)
+{
+	const UByte* bytes = (const UByte*)data;
+	Int count = 0;
+	size_t i = 0;
+
+#ifdef UTF8_USE_SSE2
+	while (i + 16 <= length)
+	{
+		// 16 ASCII characters in a row
+		Int mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(bytes + i)));
+		if (mask == 0)
+		{
+			count += 16;
+			i += 16;
+			continue;
+		}
+
+		// Otherwise walk up to the end of the block
+		size_t blockEnd = i + 16;
+		while (i < blockEnd)
+		{
+			Int units = readUtf8Char(bytes, length, i);
+			if (units == 0)
+				return -1;
+			count += units;
+		}
+	}
+#endif
+
+	while (i < length)
+	{
+		Int units = readUtf8Char(bytes, length, i);
+		if (units == 0)
+			return -1;
+		count += units;
+	}
+	return count;
+}
@@ -0,0 +1,165 @@
+#include "debug.h"
+#include "data/varintbatch.h"
+#ifdef VARINT_USE_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef VARINT_USE_AVX2
+#include <immintrin.h>
+#endif
+
+/*
+ * Both directions look at 16 bytes (or values) at a time and take a shortcut when
+ * they're all the same size, which is what long runs of ids and palette entries
+ * usually are: 16 VarInts of 1 byte, or 8 VarInts of 2 bytes. Anything else goes
+ * one VarInt at a time, but the continuation bits of the whole block are still
+ * read at once to find where the VarInt ends.
+ */
+
+// The continuation bits of 16 bytes that hold 8 VarInts of 2 bytes each
+#define VARINT_TWO_BYTE_MASK 0x5555
+
+/*************************************************
+ * decodeVarInt                                  *
+ * Reads one VarInt that's known to be size      *
+ * bytes long                                    *
+ *************************************************/
+inline Int decodeVarInt(const Byte* in, Int size)
+{
+	UInt value = 0;
+	for (Int i = 0; i < size; ++i)
+		value |= (UInt)(in[i] & 0x7f) << (7 * i);
+	return (Int)value;
+}
+
+size_t encodeVarInts(const Int* values, size_t count, Byte* out)
+{
+	Byte* start = out;
+	size_t i = 0;
+
+#ifdef VARINT_USE_SSE2
+	const __m128i small = _mm_set1_epi32(~0x7f);
+	const __m128i medium = _mm_set1_epi32(~0x3fff);
+	const __m128i zero = _mm_setzero_si128();
+	while (i + 16 <= count)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i*)(values + i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(values + i + 4));
+		__m128i c = _mm_loadu_si128((const __m128i*)(values + i + 8));
+		__m128i d = _mm_loadu_si128((const __m128i*)(values + i + 12));
+
+		// 16 values under 128 are just their own bytes
+		__m128i big = _mm_or_si128(_mm_or_si128(_mm_and_si128(a, small), _mm_and_si128(b, small)),
+			_mm_or_si128(_mm_and_si128(c, small), _mm_and_si128(d, small)));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(big, zero)) == 0xFFFF)
+		{
+			_mm_storeu_si128((__m128i*)out, _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+			out += 16;
+			i += 16;
+			continue;
+		}
+
+		// 8 values from 128 up to 16384 are two bytes each: the low 7 bits with the continuation bit, then the rest
+		__m128i tooSmall = _mm_or_si128(_mm_cmpeq_epi32(_mm_and_si128(a, small), zero), _mm_cmpeq_epi32(_mm_and_si128(b, small), zero));
+		__m128i tooBig = _mm_or_si128(_mm_and_si128(a, medium), _mm_and_si128(b, medium));
+		if (_mm_movemask_epi8(tooSmall) == 0 && _mm_movemask_epi8(_mm_cmpeq_epi32(tooBig, zero)) == 0xFFFF)
+		{
+			const __m128i low = _mm_set1_epi32(0x7f);
+			const __m128i more = _mm_set1_epi32(0x80);
+			__m128i encodedA = _mm_or_si128(_mm_or_si128(_mm_and_si128(a, low), more), _mm_slli_epi32(_mm_srli_epi32(a, 7), 8));
+			__m128i encodedB = _mm_or_si128(_mm_or_si128(_mm_and_si128(b, low), more), _mm_slli_epi32(_mm_srli_epi32(b, 7), 8));
+			_mm_storeu_si128((__m128i*)out, _mm_packs_epi32(encodedA, encodedB));
+			out += 16;
+			i += 8;
+			continue;
+		}
+
+		// Mixed sizes go one at a time until the next block
+		for (size_t end = i + 8; i < end; ++i)
+			out += VarInt::encode(values[i], out);
+	}
+#endif
+
+	for (; i < count; ++i)
+		out += VarInt::encode(values[i], out);
+	return (size_t)(out - start);
+}
+
+Long decodeVarInts(const Byte* in, size_t length, Int* out, size_t count)
+{
+	const Byte* start = in;
+	const Byte* end = in + length;
+	size_t i = 0;
+
+#ifdef VARINT_USE_AVX2
+	// 32 VarInts of 1 byte at once
+	while (i + 32 <= count && end - in >= 32)
+	{
+		__m256i bytes = _mm256_loadu_si256((const __m256i*)in);
+		if (_mm256_movemask_epi8(bytes) != 0)
+			break;
+		for (Int part = 0; part < 4; ++part)
+			_mm256_storeu_si256((__m256i*)(out + i + part * 8), _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(in + part * 8))));
+		in += 32;
+		i += 32;
+	}
+#endif
+
+#ifdef VARINT_USE_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	while (i + 16 <= count && end - in >= 16)
+	{
+		__m128i bytes = _mm_loadu_si128((const __m128i*)in);
+		Int more = _mm_movemask_epi8(bytes);
+
+		// 16 VarInts of 1 byte are just the bytes widened to ints
+		if (more == 0)
+		{
+			__m128i low = _mm_unpacklo_epi8(bytes, zero);
+			__m128i high = _mm_unpackhi_epi8(bytes, zero);
+			_mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi16(low, zero));
+			_mm_storeu_si128((__m128i*)(out + i + 4), _mm_unpackhi_epi16(low, zero));
+			_mm_storeu_si128((__m128i*)(out + i + 8), _mm_unpacklo_epi16(high, zero));
+			_mm_storeu_si128((__m128i*)(out + i + 12), _mm_unpackhi_epi16(high, zero));
+			in += 16;
+			i += 16;
+			continue;
+		}
+
+		// 8 VarInts of 2 bytes: the low byte's 7 bits, then the high byte shifted down into place
+		if (more == VARINT_TWO_BYTE_MASK)
+		{
+			__m128i values = _mm_or_si128(_mm_and_si128(bytes, _mm_set1_epi16(0x7f)), _mm_srli_epi16(_mm_and_si128(bytes, _mm_set1_epi16(0x7f00)), 1));
+			_mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi16(values, zero));
+			_mm_storeu_si128((__m128i*)(out + i + 4), _mm_unpackhi_epi16(values, zero));
+			in += 16;
+			i += 8;
+			continue;
+		}
+
+		// Otherwise the first clear continuation bit says where the next VarInt ends
+		UInt ends = ~(UInt)more & 0xFFFF;
+		if (ends == 0)
+			return -1; // 16 bytes without an end is far too long
+		Int size = 32 - countLeadingZeros(ends & (0 - ends));
+		if (size > VARINT_MAX_SIZE)
+			return -1;
+		out[i++] = decodeVarInt(in, size);
+		in += size;
+	}
+#endif
+
+	// Whatever is left (or everything, without SSE) one byte at a time
+	for (; i < count; ++i)
+	{
+		Int size = 0;
+		do
+		{
+			if (in + size >= end || size >= VARINT_MAX_SIZE)
+				return -1;
+		} while (in[size++] & 0x80);
+		out[i] = decodeVarInt(in, size);
+		in += size;
+	}
+
+	return (Long)(in - start);
+}
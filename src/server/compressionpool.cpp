@@ -0,0 +1,69 @@
+#include "debug.h"
+#include "server/compressionpool.h"
+
+/**********************************************
+ * Compression Pool :: Compression Pool       *
+ * Starts up the workers, picking one for     *
+ * every four cores if no number was given    *
+ **********************************************/
+CompressionPool::CompressionPool(Int numWorkers) : running(true)
+{
+	if (numWorkers <= 0)
+		numWorkers = std::thread::hardware_concurrency() >= 8 ? std::thread::hardware_concurrency() / 4 : 1;
+
+	for (Int i = 0; i < numWorkers; ++i)
+		workers.push_back(std::thread(&CompressionPool::run, this));
+}
+
+/**********************************************
+ * Compression Pool :: Compression Pool       *
+ * Destructor                                 *
+ **********************************************/
+CompressionPool::~CompressionPool()
+{
+	// Wake everyone up so that they notice we're done
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		running = false;
+	}
+	wakeup.notify_all();
+
+	for (size_t i = 0; i < workers.size(); ++i)
+		workers[i].join();
+}
+
+/**********************************************
+ * Compression Pool :: Push                   *
+ * Hands a job to the next free worker        *
+ **********************************************/
+void CompressionPool::push(Job job)
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		jobs.push(std::move(job));
+	}
+	wakeup.notify_one();
+}
+
+/**********************************************
+ * Compression Pool :: Run                    *
+ * Runs jobs until the pool is destroyed      *
+ **********************************************/
+void CompressionPool::run()
+{
+	std::unique_lock<std::mutex> guard(lock);
+	while (true)
+	{
+		// Sleep until there's something to do
+		wakeup.wait(guard, [this]() { return !jobs.empty() || !running; });
+		if (jobs.empty())
+			return;
+
+		// Run the job without holding up the other workers
+		Job job = std::move(jobs.front());
+		jobs.pop();
+		guard.unlock();
+		job();
+		guard.lock();
+	}
+}
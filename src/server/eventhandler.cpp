@@ -2,7 +2,7 @@
 #include "server/eventhandler.h"
 #include "server/networkhandler.h"
 #include <iostream>
-#include <ctime>
+#include <chrono>
 #include <cmath>
 
 #define DISCONNECT_TIME 10.0
@@ -71,32 +71,45 @@ void toBytes(const SerialPosition value, char* bytes)
  *****************************************/
 void EventHandler::runTickClock()
 {
-	// Set up the local variables
-	clock_t lastClock = clock();
-	clock_t newClock = clock();
-	Double dt = (newClock - lastClock) / static_cast<Double>(CLOCKS_PER_SEC);
-	Int ticksLost = static_cast<Int>(dt / tickDelay);
+	typedef std::chrono::steady_clock Clock;
+	Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<Double>(tickDelay));
+	Clock::time_point epoch = Clock::now();
+	Clock::time_point deadline = epoch;
+	Clock::time_point lastStart = epoch - period;
+	Int ticksSkipped = 0;
 
 	// While the tick clock is running, start up the tick
 	while (running)
 	{
-		// Start the tick
-		onTick(dt, ticksLost);
-
-		// Calculate the time, difference, and how many ticks were lost
-		newClock = clock();
-		dt = (newClock - lastClock) / static_cast<Double>(CLOCKS_PER_SEC);
-		ticksLost = static_cast<Int>(dt / tickDelay);
-
-		// Sleep for the remainder of the tick
-		Int timeRemaining = static_cast<Int>(1000000.0 * (tickDelay - (dt - (ticksLost * tickDelay))));
-		std::this_thread::sleep_for(std::chrono::microseconds(timeRemaining));
-
-		// Calculate the time, difference, and how many ticks were lost again
-		lastClock = newClock;	// Set the new clock to become the old
-		newClock = clock();
-		dt = (newClock - lastClock) / static_cast<Double>(CLOCKS_PER_SEC);
-		ticksLost = static_cast<Int>(dt / tickDelay);
+		// Start the tick, telling it how long it's really been since the last one started
+		Clock::time_point start = Clock::now();
+		Double dt = std::chrono::duration<Double>(start - lastStart).count();
+		lastStart = start;
+		dispatch->onTick(this, dt, ticksSkipped);
+
+		// Record how long it took
+		Clock::time_point end = Clock::now();
+		tickMetrics.record(std::chrono::duration<Double>(start - epoch).count(),
+			std::chrono::duration<Double, std::milli>(end - start).count(), ticksSkipped);
+		ticksSkipped = 0;
+
+		// Each tick is due a period after the last one was due (rather than after it finished)
+		// so that oversleeping and long ticks don't add up into drift
+		deadline += period;
+		if (end < deadline)
+		{
+			std::this_thread::sleep_until(deadline);
+			continue;
+		}
+
+		// Behind schedule, the missed ticks run back to back until we've caught up, unless
+		// we're so far behind that they're skipped (and the next tick is told how many)
+		Long behind = (end - deadline) / period;
+		if (behind >= TICK_CATCHUP_LIMIT)
+		{
+			ticksSkipped = (Int)behind;
+			deadline += behind * period;
+		}
 	}
 }
 
@@ -122,81 +135,150 @@ Position toChunkPosition(PositionF position)
 /*****************************/
 void EventHandler::onTick(Double dt, Int ticksSkipped)
 {
-	// Finish off the job queue before-hand
-	jobQueue.start(false);
-	
-	// Run this on every client
-	for each (Client* client in clients)
+	// Handle everything that came in since the last tick
+	tickInbound();
+
+	// Move the world along
+	tickWorld(1 + ticksSkipped);
+
+	// Keep the clients up to date with what's around them
+	tickTracking();
+
+	// Spend the rest of the budget on the work that can wait
+	tickDeferred();
+
+	// Send everything that was queued up this tick
+	networkHandler->flushClients();
+}
+
+/*************************************************
+ * EventHandler :: tickInbound                   *
+ * Runs the jobs from other threads and the      *
+ * events the network threads read               *
+ *************************************************/
+void EventHandler::tickInbound()
+{
+	// The network threads add and remove clients whenever they like, so the rest of the tick goes by a copy
+	tickClients = clients.snapshot();
+
+	// Finish off the jobs that can't wait, bulk work is left for the deferred phase
+	jobQueue.run(JobPriority::Normal);
+
+	// Handle everything the network threads read since the last tick
+	networkHandler->runInbound();
+}
+
+/*************************************************
+ * EventHandler :: tickWorld                     *
+ * Moves the world along by the given number of  *
+ * ticks                                         *
+ *************************************************/
+void EventHandler::tickWorld(Int ticks)
+{
+	// Run this on every client that's currently in play
+	for (Client* client : tickClients)
 	{
-		// For clients that are currently in play:
 		if (client->getState() == ServerState::Play)
 		{
 			// Update the client's ticks
-			Long uptime = client->incrementUptime(1 + ticksSkipped);
-			Int ticksSinceUpdate = client->incrementTicksSinceUpdate(1 + ticksSkipped);
+			client->incrementUptime(ticks);
+			client->incrementTicksSinceUpdate(ticks);
 
 			// TODO: Update the things that need to be updated every tick
+		}
+	}
+}
 
-			// If the client has been out for too long, disconnect it. :(
-			if (ticksSinceUpdate > static_cast<Double>(DISCONNECT_TIME / tickDelay))
-			{
-				// TODO: Hate to do this, but implement a disconnect.
-			}
-			// Update the things that are only updated once in a while
-			else if (ticksSinceUpdate > 20)
+/*************************************************
+ * EventHandler :: tickTracking                  *
+ * Checks on the clients and what they can see   *
+ *************************************************/
+void EventHandler::tickTracking()
+{
+	for (Client* client : tickClients)
+	{
+		if (client->getState() != ServerState::Play)
+			continue;
+
+		// If the client has been out for too long, disconnect it. :(
+		Int ticksSinceUpdate = client->getTicksSinceUpdate();
+		if (ticksSinceUpdate > static_cast<Double>(DISCONNECT_TIME / tickDelay))
+		{
+			// TODO: Hate to do this, but implement a disconnect.
+		}
+		// Update the things that are only updated once in a while
+		else if (ticksSinceUpdate > 20)
+		{
+			// Ask if the player is still alive
+			// TODO: Prompt for a random number and test for it
+			networkHandler->sendKeepAlive(client, 0);
+
+			// TODO: Give the client the time
+			//			timeUpdate(client);
+
+			/* Load and unload chunks when necessary
+			// Determine dimensions to check for
+			// TODO: Load chunks in circle instead of square
+			Position chunkPosition = toChunkPosition(client->position);
+			Int minx = chunkPosition.x - client->viewDistance;
+			Int maxx = chunkPosition.x + client->viewDistance;
+			Int minz = chunkPosition.z - client->viewDistance;
+			Int maxz = chunkPosition.z + client->viewDistance;
+			Int diameter = client->viewDistance * 2 + 1;
+			Boolean* chunkLoaded = new Boolean[diameter * diameter];
+
+			// Set the entire array to false
+			for (int i = 0; i < diameter * diameter; ++i)
+				chunkLoaded[i] = false;
+
+			// Check if every chunk that needs to be loaded is loaded and unload every other chunk
+			for each (std::pair<Int, Int> chunk in client->loadedChunks)
 			{
-				// Ask if the player is still alive
-				// TODO: Prompt for a random number and test for it
-				// TODO: Uncomment code when eventhandler no longer runs on several threads
-				networkHandler->sendKeepAlive(client, 0);
-
-				// TODO: Give the client the time
-				//			timeUpdate(client);
-
-				/* Load and unload chunks when necessary
-				// Determine dimensions to check for
-				// TODO: Load chunks in circle instead of square
-				Position chunkPosition = toChunkPosition(client->position);
-				Int minx = chunkPosition.x - client->viewDistance;
-				Int maxx = chunkPosition.x + client->viewDistance;
-				Int minz = chunkPosition.z - client->viewDistance;
-				Int maxz = chunkPosition.z + client->viewDistance;
-				Int diameter = client->viewDistance * 2 + 1;
-				Boolean* chunkLoaded = new Boolean[diameter * diameter];
-
-				// Set the entire array to false
-				for (int i = 0; i < diameter * diameter; ++i)
-					chunkLoaded[i] = false;
-
-				// Check if every chunk that needs to be loaded is loaded and unload every other chunk
-				for each (std::pair<Int, Int> chunk in client->loadedChunks)
+				// Move the chunk to dimensions that should fit the array
+				Int x = chunk.first - minx;
+				Int z = chunk.second - minz;
+
+				// If the chunk doesn't fit into the array then unload it
+				if (x < 0 || z < 0 || x >= diameter || z >= diameter)
 				{
-					// Move the chunk to dimensions that should fit the array
-					Int x = chunk.first - minx;
-					Int z = chunk.second - minz;
-
-					// If the chunk doesn't fit into the array then unload it
-					if (x < 0 || z < 0 || x >= diameter || z >= diameter)
-					{
-						networkHandler->sendUnloadChunk(client, chunk);
-					}
-					else
-						chunkLoaded[x * diameter + z] = true;
+					networkHandler->sendUnloadChunk(client, chunk);
 				}
+				else
+					chunkLoaded[x * diameter + z] = true;
+			}
 
-				// Load any chunks that have not yet been loaded
-				for (Int x = 0; x < diameter; ++x)
-					for (Int z = 0; z < diameter; ++z)
-						if (!chunkLoaded[x * diameter + z])
-							networkHandler->sendChunk(client, x, z, true, true);
+			// Load any chunks that have not yet been loaded
+			for (Int x = 0; x < diameter; ++x)
+				for (Int z = 0; z < diameter; ++z)
+					if (!chunkLoaded[x * diameter + z])
+						networkHandler->sendChunk(client, x, z, true, true);
 
-				// Free the memory
-				delete[] chunkLoaded; */
-			}
+			// Free the memory
+			delete[] chunkLoaded; */
 		}
 	}
 }
 
+/*************************************************
+ * EventHandler :: tickDeferred                  *
+ * Streams chunks and runs bulk jobs until the   *
+ * budget runs out, leaving the rest for the     *
+ * next tick. Something always gets done so that *
+ * nothing waits forever on a slow server        *
+ *************************************************/
+void EventHandler::tickDeferred()
+{
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now()
+		+ std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<Double>(deferredBudget));
+
+	// Chunks come first since players are waiting on them
+	Int done = networkHandler->streamChunks(deadline);
+
+	// Then whatever else was put off, still behind any urgent jobs that came in since
+	if (done == 0 || std::chrono::steady_clock::now() < deadline)
+		jobQueue.run(JobPriority::Bulk, deadline);
+}
+
 /*************************************************
  * EventHandler :: invalidPacket                 *
  * The client sent an invalid packet             *
@@ -233,6 +315,10 @@ void EventHandler::clientDisconnect(ClientDisconnectEventArgs e)
 	// Erase the client
 	// TODO: Alert all other players of the disconnect
 	std::cout << e.client->getName() << " has disconnected.\n";
+
+	// Take the player out of the server list's count
+	if (e.client->getState() == ServerState::Play)
+		networkHandler->getStatus().removePlayer(UUID(e.client).str());
 //	clients.erase(e.client);
 }
 
@@ -256,24 +342,6 @@ void EventHandler::legacyServerListPing(LegacyServerListPingEventArgs e)
 
 }
 
-/*************************************************
- * EventHandler :: ping                          *
- * The client is pinging the server              *
- *************************************************/
-void EventHandler::ping(PingEventArgs e)
-{
-
-}
-
-/**********************************************
- * EventHandler :: request                    *
- * The client is requesting a response packet *
- **********************************************/
-void EventHandler::request(RequestEventArgs e)
-{
-	
-}
-
 /*************************************************
  * EventHandler :: encryptionResponse            *
  * The client has accepted the data encryption   *
@@ -290,7 +358,8 @@ void EventHandler::encryptionResponse(EncryptionResponseEventArgs e)
 void EventHandler::loginStart(LoginStartEventArgs e)
 {
 	// Set some information for the client
-	e.client->setName(e.name);
+	String name = String(e.name);
+	e.client->setName(name);
 	e.client->setState(ServerState::Play);
 	e.client->setGamemode(Gamemode::Survival);
 	e.client->setDimension(Dimension::Overworld);
@@ -299,9 +368,14 @@ void EventHandler::loginStart(LoginStartEventArgs e)
 	e.client->resetUptime();
 	e.client->resetTicksSinceUpdate();
 
+	// Compress everything from here on out if the network handler wants to
+	if (networkHandler->getCompressionThreshold() >= 0)
+		networkHandler->sendSetCompression(e.client, networkHandler->getCompressionThreshold());
+
 	// Don't doubt the client, just let them in. ;-)
 	// TODO: Create a hash from the client's name
-	networkHandler->sendLoginSuccess(e.client, UUID(e.client), e.name);
+	networkHandler->sendLoginSuccess(e.client, UUID(e.client), name);
+	networkHandler->getStatus().addPlayer(name, UUID(e.client).str());
 
 	// Let the client join the game
 	networkHandler->sendJoinGame(e.client, e.client->getEntityID(), Gamemode::Survival, Dimension::Overworld, Difficulty::Peaceful, 8, LevelType::Default);
@@ -336,9 +410,13 @@ void EventHandler::animation(AnimationEventArgs e)
 void EventHandler::chatMessage(ChatMessageEventArgs e)
 {
 	// Forward the message to every client that is in play mode
-	for (AtomicSet<Client*, ClientComparator>::iterator it = clients.begin(); it != clients.end(); ++it)
-		if ((*it)->getState() == ServerState::Play)
-			networkHandler->sendChatMessage(*it, e.client->getName() + String(": ") + e.message);
+	std::vector<Client*> recipients;
+	for (Client* client : tickClients)
+		if (client->getState() == ServerState::Play)
+			recipients.push_back(client);
+	String message = e.client->getName() + String(": ");
+	message.append(e.message);
+	networkHandler->broadcastChatMessage(recipients, message);
 }
 
 /*************************************************
@@ -354,29 +432,42 @@ void EventHandler::clickWindow(ClickWindowEventArgs e)
  * EventHandler :: clientSettings                 *
  * The client wants to set or change its settings *
  **************************************************/
-void EventHandler::clientSettings(ClientSettingsEventArgs e)
+Async<void> EventHandler::clientSettings(ClientSettingsEventArgs e)
 {
-	// Save the settings
+	// Save the settings (the locale points into the network thread's batch, so it's copied before anything is awaited)
 	e.client->setChatColors(e.chatColors);
 	e.client->setChatMode(e.chatMode);
 	e.client->setSkinParts(e.displayedSkinParts);
-	e.client->setLocale(e.locale);
+	e.client->setLocale(String(e.locale));
 	e.client->setMainHand(e.mainHand);
 	e.client->setViewDistance(e.viewDistance);
 
 	// If the player hasn't spawned yet then spawn them in
 	// TODO: Create playerSpawned event
-	if (e.client->loadedChunks.empty())
+	if (e.client->loadedChunks.empty() && e.client->deferredChunks.empty())
 	{
-		// Send the chunks over
+		// Claim the spawn area right away so that it isn't sent twice while it's being built
+		Client* client = e.client;
+		std::vector< std::pair<Int, Int> > chunks;
 		for (int x = -3; x <= 3; ++x)
 			for (int z = -3; z <= 3; ++z)
-				networkHandler->sendChunk(e.client, x, z, true, true);
+				chunks.push_back(std::pair<Int, Int>(x, z));
+		for (size_t i = 0; i < chunks.size(); ++i)
+			client->loadedChunks.insert(chunks[i]);
+
+		// Build the chunks on the workers while the ticks go on, then send them from the server thread
+		// (the task is kept in a local since GCC 12 destroys the temporaries of a co_await's operand twice)
+		Async< std::vector< std::shared_ptr<const String> > > encoding = runAsync([this, client, &chunks]()
+			{ return networkHandler->encodeChunks(client, chunks, true, true); });
+		std::vector< std::shared_ptr<const String> > packets = co_await encoding;
+		if (clients.count(client) == 0)
+			co_return;
+		networkHandler->sendEncodedChunks(client, chunks, packets);
 
 		// TODO: Use an actual keep alive and teleport id
-		networkHandler->sendKeepAlive(e.client, 0);
-		networkHandler->sendPlayerPositionAndLook(e.client, PositionF(0.0, 255.0, 0.0), 0.0, 0.0, PlayerPositionAndLookFlags(false, false, false, false, false), 0);
-		networkHandler->sendChatMessage(e.client, "Welcome to \\u00a74Super \\u00a76\\u00a7lSMASH \\u00a74Craft\\u00a7r!", ChatMessageType::GameInfo);
+		networkHandler->sendKeepAlive(client, 0);
+		networkHandler->sendPlayerPositionAndLook(client, PositionF(0.0, 255.0, 0.0), 0.0, 0.0, PlayerPositionAndLookFlags(false, false, false, false, false), 0);
+		networkHandler->sendChatMessage(client, "Welcome to \\u00a74Super \\u00a76\\u00a7lSMASH \\u00a74Craft\\u00a7r!", ChatMessageType::GameInfo);
 	}
 }
 
@@ -665,7 +756,7 @@ ChunkColumn& EventHandler::getChunk(GetChunkEventArgs& e)
 	{
 		e2.pos.y = i;
 		e2.chunk = &e.chunk.chunks[i];
-		getChunkSection(e2);
+		dispatch->getChunkSection(this, e2);
 	}
 
 	return e.chunk;
@@ -688,7 +779,7 @@ BiomeID* EventHandler::getBiomes(GetBiomeEventArgs& e)
  * EventHandler :: EventHandler             *
  * Default Constructor                      *
  ********************************************/
-EventHandler::EventHandler() : running(false), networkHandler(NULL), clients() {}
+EventHandler::EventHandler() : deferredBudget(TICK_DEFERRED_BUDGET), running(false), dispatch(&dispatchFor<EventHandler>()), networkHandler(NULL), clients() {}
 
 /********************************************
  * EventHandler :: EventHandler             *
@@ -699,7 +790,7 @@ EventHandler::~EventHandler() { stopTickClock(); }
 /**************************************
  * EventHandler :: startTick          *
  * Starts the server's game tick loop *
- * The delay is in micro seconds      *
+ * The delay is in seconds            *
  **************************************/
 void EventHandler::startTickClock(Double delay)
 {
@@ -0,0 +1,106 @@
+#include "debug.h"
+#include "server/eventqueue.h"
+#include <cstring>
+
+/**************************************************
+ * Event Batch :: allocate                        *
+ * Finds room for size bytes in the blocks, only  *
+ * making a new block when the old ones are full  *
+ **************************************************/
+void* EventBatch::allocate(size_t size, size_t alignment)
+{
+	// Anything that would take up a good part of a block gets its own memory
+	if (size > EVENTBATCH_BLOCK_SIZE / 4)
+	{
+		large.push_back(std::unique_ptr<Byte[]>(new Byte[size]));
+		return large.back().get();
+	}
+
+	while (true)
+	{
+		if (block < blocks.size())
+		{
+			size_t start = (used + alignment - 1) & ~(alignment - 1);
+			if (start + size <= EVENTBATCH_BLOCK_SIZE)
+			{
+				used = start + size;
+				return blocks[block].get() + start;
+			}
+
+			// Move on to the next block
+			++block;
+			used = 0;
+			continue;
+		}
+		blocks.push_back(std::unique_ptr<Byte[]>(new Byte[EVENTBATCH_BLOCK_SIZE]));
+	}
+}
+
+/**************************************************
+ * Event Batch :: keep                            *
+ * Copies the text into the batch                 *
+ **************************************************/
+StringView EventBatch::keep(StringView text)
+{
+	if (text.empty())
+		return StringView();
+	char* copy = (char*)allocate(text.size(), 1);
+	memcpy(copy, text.data(), text.size());
+	return StringView(copy, text.size());
+}
+
+/**************************************************
+ * Event Batch :: keep                            *
+ * Copies the data into the batch                 *
+ **************************************************/
+Byte* EventBatch::keep(const Byte* data, Int length)
+{
+	if (data == NULL || length <= 0)
+		return NULL;
+	Byte* copy = (Byte*)allocate((size_t)length, 1);
+	memcpy(copy, data, (size_t)length);
+	return copy;
+}
+
+/**************************************************
+ * Event Batch :: run                             *
+ * Gives every event to the event handler         *
+ **************************************************/
+void EventBatch::run(EventHandler* handler, const EventDispatch& dispatch)
+{
+	dispatch.runBatch(handler, *this);
+	clear();
+}
+
+/**************************************************
+ * Event Batch :: clear                           *
+ * Destroys everything in the batch, keeping the  *
+ * blocks to fill again                           *
+ **************************************************/
+void EventBatch::clear()
+{
+	for (size_t i = 0; i < records.size(); ++i)
+		records[i].destroy(records[i].e);
+	records.clear();
+	large.clear();
+	block = 0;
+	used = 0;
+}
+
+/**************************************************
+ * Event Queue :: run                             *
+ * Trades the batch being filled for the empty    *
+ * one and runs it                                *
+ **************************************************/
+void EventQueue::run(EventHandler* handler, const EventDispatch& dispatch)
+{
+	EventBatch* ready;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		if (filling->empty())
+			return;
+		ready = filling;
+		filling = filling == &batches[0] ? &batches[1] : &batches[0];
+	}
+	ready->run(handler, dispatch);
+}
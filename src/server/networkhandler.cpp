@@ -3,352 +3,630 @@
 #include "server/eventhandler.h"
 #include "data/networkpackets.h"
 #include "data/bitstream.h"
+#include "data/compression.h"
+#include "data/packetwriter.h"
+#include "data/packetschema.h"
+#include "data/varintbatch.h"
 #include <iostream>
 #include <thread>
+#include <chrono>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
+
+#ifdef NETWORK_USE_EPOLL
+#include <sys/epoll.h>
+#endif
+
+#ifdef NETWORK_USE_IO_URING
+#include <liburing.h>
+#include <sys/eventfd.h>
+#include <mutex>
+#include <vector>
+#include <map>
+#include <set>
+
+#define URING_QUEUE_DEPTH  4096
+#define URING_NUM_BUFFERS  1024  // Has to be a power of two
+#define URING_BUFFER_SIZE  16384
+#define URING_BUFFER_GROUP 0
+
+// What a submitted io_uring request is doing
+enum class UringOp { Accept, Receive, Send, Wake };
+
+// The data attached to every io_uring request
+struct UringRequest
+{
+	UringOp op;
+	Client* client;
+	OutboundQueue data;             // The bytes being sent (only used by sends)
+	iovec iov[OUTBOUND_MAX_SLICES]; // Where each piece of that data is
+	msghdr msg;                     // The message handed to the kernel
+	UringRequest(UringOp op, Client* client = NULL) : op(op), client(client) {}
+};
 
-/**************************************************
- * copyBuffer                                     *
- * Creates a byte array from another array        *
- * The new array will need to be deleted manually *
- **************************************************/
-Byte* copyBuffer(const Byte* data, Int length)
+/*******************************************************************
+ * UringState                                                      *
+ * Everything the io_uring backend keeps around between iterations *
+ *******************************************************************/
+struct UringState
+{
+	io_uring ring;
+	io_uring_buf_ring* bufferRing; // The buffers the kernel picks from for every receive
+	char* buffers;                 // URING_NUM_BUFFERS buffers of URING_BUFFER_SIZE bytes each
+	int wakeFD;                    // An eventfd that other threads poke when they leave work for the ring
+	ULong wakeValue;               // Where the eventfd's counter gets read into
+	UringRequest wakeRequest;      // The read that always waits on the eventfd
+	UringRequest acceptRequest;    // The multishot accept on the thread's listener
+
+	// Only touched by the network thread
+	std::map<Client*, UringRequest*> receives; // The multishot receive armed for each client
+	std::map<Client*, UringRequest*> sending;  // The send each client has in flight
+	std::set<Client*> lingering;               // Closed clients whose descriptors stay open until their send completes
+	std::vector<Client*> starved;              // Clients whose receives stopped because there were no buffers left
+
+	// Shared with the other threads
+	std::mutex lock;
+	Boolean wakePending;                              // Whether the ring was already poked
+	std::vector<Client*> newClients;                  // Clients that still need a receive armed
+	std::vector<Client*> flushes;                     // Clients whose outbound queues still need to be submitted
+
+	UringState() : bufferRing(NULL), buffers(NULL), wakeFD(-1), wakeValue(0), wakeRequest(UringOp::Wake), acceptRequest(UringOp::Accept), wakePending(false) {}
+	char* getBuffer(UShort id) { return buffers + (size_t)id * URING_BUFFER_SIZE; }
+	void wake() { if (!wakePending) { wakePending = true; ULong one = 1; write(wakeFD, &one, sizeof(one)); } }
+};
+
+/****************************************************
+ * getSqe                                           *
+ * Grabs a submission queue entry, submitting       *
+ * everything queued so far if the queue is full    *
+ ****************************************************/
+io_uring_sqe* getSqe(UringState& u)
 {
-	// Copy the contents of the buffer to a new array
-	Byte* buf = new Byte[length];
-	for (int i = 0; i < length; i++)
-		buf[i] = data[i];
-	return buf;
+	io_uring_sqe* sqe = io_uring_get_sqe(&u.ring);
+	if (sqe == NULL)
+	{
+		io_uring_submit(&u.ring);
+		sqe = io_uring_get_sqe(&u.ring);
+	}
+
+	return sqe;
 }
 
-/**************************
- * parseLong              *
- * Reads a long from data *
- **************************/
-Long parseLong(const Byte* data)
+/****************************************************
+ * armReceive                                       *
+ * Starts a multishot receive for the request's     *
+ * client that reads into the provided buffer group *
+ ****************************************************/
+void armReceive(UringState& u, UringRequest* request)
 {
-	return (((Long)data[0]) << 56) + (((Long)data[1]) << 48) + (((Long)data[2]) << 40) +
-		   (((Long)data[3]) << 32) + (data[4] << 24) + (data[5] << 16) + (data[6] << 8) + data[7];
+	io_uring_sqe* sqe = getSqe(u);
+	io_uring_prep_recv_multishot(sqe, request->client->getSocket(), NULL, 0, 0);
+	sqe->flags |= IOSQE_BUFFER_SELECT;
+	sqe->buf_group = URING_BUFFER_GROUP;
+	io_uring_sqe_set_data(sqe, request);
 }
 
-/**************************
- * parseInt               *
- * Reads an int from data *
- **************************/
-Int parseInt(const Byte* data)
+/***************************************************
+ * armSend                                         *
+ * Sends whatever is left of a request's data as a *
+ * single gather write                             *
+ ***************************************************/
+void armSend(UringState& u, UringRequest* request)
 {
-	return (data[0] << 24) + (data[1] << 16) + (data[2] << 8) + data[3];
+	OutboundSlice slices[OUTBOUND_MAX_SLICES];
+	Int count = request->data.getSlices(slices, OUTBOUND_MAX_SLICES);
+	for (Int i = 0; i < count; ++i)
+	{
+		request->iov[i].iov_base = (void*)slices[i].data;
+		request->iov[i].iov_len = slices[i].length;
+	}
+	request->msg = msghdr();
+	request->msg.msg_iov = request->iov;
+	request->msg.msg_iovlen = count;
+
+	io_uring_sqe* sqe = getSqe(u);
+	io_uring_prep_sendmsg(sqe, request->client->getSocket(), &request->msg, MSG_NOSIGNAL);
+	io_uring_sqe_set_data(sqe, request);
 }
 
-/***************************
- * parseShort              *
- * Reads a short from data *
- ***************************/
-Short parseShort(const Byte* data)
+/*****************************************************
+ * startSend                                         *
+ * Takes everything in the client's outbound queue   *
+ * that's ready and sends it. Returns false if there *
+ * was nothing                                       *
+ *****************************************************/
+Boolean startSend(UringState& u, UringRequest* request)
 {
-	return (data[0] << 8) + data[1];
+	request->client->outbound.moveReadyTo(request->data);
+	if (request->data.empty())
+		return false;
+
+	u.sending[request->client] = request;
+	armSend(u, request);
+	return true;
 }
 
-/****************************
- * parseDouble              *
- * Reads a double from data *
- ****************************/
-Double parseDouble(const Byte* data)
+/****************************************************
+ * armAccept                                        *
+ * Starts a multishot accept on the given listener  *
+ ****************************************************/
+void armAccept(UringState& u, SOCKET listener)
 {
-	Long num = parseLong(data);
-	return reinterpret_cast<Double&>(num);
+	io_uring_sqe* sqe = getSqe(u);
+	io_uring_prep_multishot_accept(sqe, listener, NULL, NULL, 0);
+	io_uring_sqe_set_data(sqe, &u.acceptRequest);
 }
 
-/***************************
- * parseFloat              *
- * Reads a float from data *
- ***************************/
-Float parseFloat(const Byte* data)
+/**************************************************
+ * armWake                                        *
+ * Waits for another thread to poke the eventfd   *
+ **************************************************/
+void armWake(UringState& u)
 {
-	Int num = parseInt(data);
-	return reinterpret_cast<Float&>(num);
+	io_uring_sqe* sqe = getSqe(u);
+	io_uring_prep_read(sqe, u.wakeFD, &u.wakeValue, sizeof(u.wakeValue), 0);
+	io_uring_sqe_set_data(sqe, &u.wakeRequest);
 }
 
-/*************************
- * writeLong             *
- * Writes a long to data *
- *************************/
-void writeLong(String& data, const Long num)
+/*********************************************
+ * recycleBuffers                            *
+ * Hands the given buffers back to the kernel *
+ *********************************************/
+void recycleBuffers(UringState& u, const std::vector<UShort>& ids)
 {
-	data.append(1, (num >> 56) & 0xFF);
-	data.append(1, (num >> 48) & 0xFF);
-	data.append(1, (num >> 40) & 0xFF);
-	data.append(1, (num >> 32) & 0xFF);
-	data.append(1, (num >> 24) & 0xFF);
-	data.append(1, (num >> 16) & 0xFF);
-	data.append(1, (num >> 8) & 0xFF);
-	data.append(1, num & 0xFF);
+	for (size_t i = 0; i < ids.size(); ++i)
+		io_uring_buf_ring_add(u.bufferRing, u.getBuffer(ids[i]), URING_BUFFER_SIZE, ids[i], io_uring_buf_ring_mask(URING_NUM_BUFFERS), i);
+	io_uring_buf_ring_advance(u.bufferRing, ids.size());
 }
 
-/*************************
- * writeLong             *
- * Writes a long to data *
- *************************/
-void writeLongB(String& data, const Long num)
+/*************************************************
+ * createUring                                   *
+ * Sets up a ring and its provided buffers       *
+ * Returns NULL if io_uring couldn't be set up   *
+ *************************************************/
+UringState* createUring()
 {
-	data.append(1, num & 0xFF);
-	data.append(1, (num >> 8) & 0xFF);
-	data.append(1, (num >> 16) & 0xFF);
-	data.append(1, (num >> 24) & 0xFF);
-	data.append(1, (num >> 32) & 0xFF);
-	data.append(1, (num >> 40) & 0xFF);
-	data.append(1, (num >> 48) & 0xFF);
-	data.append(1, (num >> 56) & 0xFF);
+	// Create the ring
+	UringState* u = new UringState();
+	int ret = io_uring_queue_init(URING_QUEUE_DEPTH, &u->ring, 0);
+	if (ret < 0)
+	{
+		std::cout << "Error creating io_uring: " << -ret << "\n";
+		delete u;
+		return NULL;
+	}
+
+	// Register the buffer ring that receives pick their buffers from
+	u->bufferRing = io_uring_setup_buf_ring(&u->ring, URING_NUM_BUFFERS, URING_BUFFER_GROUP, 0, &ret);
+	u->wakeFD = eventfd(0, EFD_CLOEXEC);
+	if (u->bufferRing == NULL || u->wakeFD == -1)
+	{
+		std::cout << "Error registering io_uring buffers: " << -ret << "\n";
+		if (u->wakeFD != -1)
+			close(u->wakeFD);
+		io_uring_queue_exit(&u->ring);
+		delete u;
+		return NULL;
+	}
+
+	// Give every buffer to the kernel
+	u->buffers = new char[(size_t)URING_NUM_BUFFERS * URING_BUFFER_SIZE];
+	std::vector<UShort> ids(URING_NUM_BUFFERS);
+	for (int i = 0; i < URING_NUM_BUFFERS; ++i)
+		ids[i] = i;
+	recycleBuffers(*u, ids);
+
+	return u;
 }
 
-/*************************
- * writeInt              *
- * Writes an int to data *
- *************************/
-void writeInt(String& data, const Int num)
+/************************************
+ * destroyUring                     *
+ * Tears down the ring and buffers  *
+ ************************************/
+void destroyUring(UringState* u)
 {
-	data.append(1, (num >> 24) & 0xFF);
-	data.append(1, (num >> 16) & 0xFF);
-	data.append(1, (num >> 8) & 0xFF);
-	data.append(1, num & 0xFF);
+	io_uring_free_buf_ring(&u->ring, u->bufferRing, URING_NUM_BUFFERS, URING_BUFFER_GROUP);
+	io_uring_queue_exit(&u->ring);
+	close(u->wakeFD);
+	for (std::map<Client*, UringRequest*>::iterator it = u->receives.begin(); it != u->receives.end(); ++it)
+		delete it->second;
+	for (std::map<Client*, UringRequest*>::iterator it = u->sending.begin(); it != u->sending.end(); ++it)
+		delete it->second;
+	delete[] u->buffers;
+	delete u;
 }
+#endif
 
-/**************************
- * writeShort             *
- * Writes a short to data *
- **************************/
-void writeShort(String& data, const Short num)
+/**************************************************
+ * socketWouldBlock                               *
+ * Whether the last socket call failed only       *
+ * because it would have had to wait              *
+ **************************************************/
+Boolean socketWouldBlock()
 {
-	data.append(1, (num >> 8) & 0xFF);
-	data.append(1, num & 0xFF);
+#ifdef _WIN32
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+	return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
 }
 
-/***************************
- * writeDouble             *
- * Writes a double to data *
- ***************************/
-// TODO: Verify cross-platform validity
-void writeDouble(String& data, const Double num)
+/*****************************************************************
+ * compressPacket                                                *
+ * Deflates a packet's id and data into the compressed packet    *
+ * format                                                        *
+ *****************************************************************/
+#define COMPRESSED_HEADER_SIZE 10
+String compressPacket(const String& body, Int level)
 {
-	writeLong(data, reinterpret_cast<const Long&>(num));
+	// Leave room in front for the lengths, which can't be known until it's deflated
+	String data(COMPRESSED_HEADER_SIZE, '\0');
+	Int bodySize = (Int)body.size();
+	if (!deflateData(body.data(), body.size(), data, level))
+	{
+		// Fall back to sending it uncompressed, which the format allows for any size
+		std::cout << "Error compressing a packet of " << bodySize << " bytes\n";
+		data.resize(COMPRESSED_HEADER_SIZE);
+		data.append(body);
+		bodySize = 0;
+	}
+
+	// Write the lengths right up against the body and drop the room that wasn't needed
+	char dataLength[5];
+	char length[5];
+	Int dataLengthSize = PacketWriter::encodeVarInt(dataLength, bodySize);
+	Int lengthSize = PacketWriter::encodeVarInt(length, (UInt)(data.size() - COMPRESSED_HEADER_SIZE + dataLengthSize));
+	size_t start = COMPRESSED_HEADER_SIZE - dataLengthSize - lengthSize;
+	memcpy(&data[start], length, lengthSize);
+	memcpy(&data[start + lengthSize], dataLength, dataLengthSize);
+	data.erase(0, start);
+	return data;
 }
 
-/**************************
- * writeFloat             *
- * Writes a float to data *
- **************************/
-// TODO: Verify cross-platform validity
-void writeFloat(String& data, const Float num)
-{
-	writeInt(data, reinterpret_cast<const Int&>(num));
+/**************************************************
+ * encodePacket                                   *
+ * Finishes a packet for a client with the given  *
+ * threshold, deflating it right here if it needs *
+ * it, and hands back a copy that can be shared   *
+ **************************************************/
+std::shared_ptr<const String> encodePacket(PacketWriter& packet, Int threshold, Int level)
+{
+	if (threshold >= 0 && packet.getBodySize() >= threshold)
+		return std::make_shared<const String>(compressPacket(String(packet.getBody(), packet.getBodySize()), level));
+	packet.finish(threshold >= 0);
+	return std::make_shared<const String>(packet.getData(), packet.getSize());
+}
+
+// The fields of every packet the client sends that has a fixed layout
+typedef PacketSchema<HandShakeEventArgs,
+	Field<VarIntCodec, &HandShakeEventArgs::protocolVersion>,
+	Field<StringCodec, &HandShakeEventArgs::serverAddress>,
+	Field<UShortCodec, &HandShakeEventArgs::serverPort>,
+	Field<VarIntCodec, &HandShakeEventArgs::state>> HandShakeSchema;
+typedef PacketSchema<PingEventArgs,
+	Field<LongCodec, &PingEventArgs::payload>> PingSchema;
+typedef PacketSchema<LoginStartEventArgs,
+	Field<StringCodec, &LoginStartEventArgs::name>> LoginStartSchema;
+typedef PacketSchema<TeleportConfirmEventArgs,
+	Field<VarIntCodec, &TeleportConfirmEventArgs::teleportID>> TeleportConfirmSchema;
+typedef PacketSchema<TabCompleteEventArgs,
+	Field<StringCodec, &TabCompleteEventArgs::text>,
+	Field<BooleanCodec, &TabCompleteEventArgs::assumeCommand>,
+	Field<BooleanCodec, &TabCompleteEventArgs::hasPosition>> TabCompleteSchema;
+typedef PacketSchema<ChatMessageEventArgs,
+	Field<StringCodec, &ChatMessageEventArgs::message>> ChatMessageSchema;
+typedef PacketSchema<ClientStatusEventArgs,
+	Field<VarIntCodec, &ClientStatusEventArgs::action>> ClientStatusSchema;
+typedef PacketSchema<ClientSettingsEventArgs,
+	Field<StringCodec, &ClientSettingsEventArgs::locale>,
+	Field<ByteCodec, &ClientSettingsEventArgs::viewDistance>,
+	Field<VarIntCodec, &ClientSettingsEventArgs::chatMode>,
+	Field<BooleanCodec, &ClientSettingsEventArgs::chatColors>,
+	Field<ByteCodec, &ClientSettingsEventArgs::displayedSkinParts>,
+	Field<VarIntCodec, &ClientSettingsEventArgs::mainHand>> ClientSettingsSchema;
+typedef PacketSchema<ConfirmTransactionEventArgs,
+	Field<UByteCodec, &ConfirmTransactionEventArgs::windowID>,
+	Field<ShortCodec, &ConfirmTransactionEventArgs::actionNum>,
+	Field<BooleanCodec, &ConfirmTransactionEventArgs::accepted>> ConfirmTransactionSchema;
+typedef PacketSchema<EnchantItemEventArgs,
+	Field<UByteCodec, &EnchantItemEventArgs::windowID>,
+	Field<ByteCodec, &EnchantItemEventArgs::enchantment>> EnchantItemSchema;
+typedef PacketSchema<CloseWindowEventArgs,
+	Field<UByteCodec, &CloseWindowEventArgs::windowID>> CloseWindowSchema;
+typedef PacketSchema<KeepAliveEventArgs,
+	Field<LongCodec, &KeepAliveEventArgs::id>> KeepAliveSchema;
+typedef PacketSchema<PlayerPositionEventArgs,
+	Field<PositionFCodec, &PlayerPositionEventArgs::position>,
+	Field<BooleanCodec, &PlayerPositionEventArgs::onGround>> PlayerPositionSchema;
+typedef PacketSchema<PlayerPositionAndLookEventArgs,
+	Field<PositionFCodec, &PlayerPositionAndLookEventArgs::position>,
+	Field<FloatCodec, &PlayerPositionAndLookEventArgs::yaw>,
+	Field<FloatCodec, &PlayerPositionAndLookEventArgs::pitch>,
+	Field<BooleanCodec, &PlayerPositionAndLookEventArgs::onGround>> PlayerPositionAndLookSchema;
+typedef PacketSchema<PlayerLookEventArgs,
+	Field<FloatCodec, &PlayerLookEventArgs::yaw>,
+	Field<FloatCodec, &PlayerLookEventArgs::pitch>,
+	Field<BooleanCodec, &PlayerLookEventArgs::onGround>> PlayerLookSchema;
+typedef PacketSchema<PlayerOnGroundEventArgs,
+	Field<BooleanCodec, &PlayerOnGroundEventArgs::onGround>> PlayerOnGroundSchema;
+
+// The fields of the packets the server sends with a fixed layout
+typedef PacketFields<LongCodec> PongFields;
+typedef PacketFields<VarIntCodec> SetCompressionFields;
+typedef PacketFields<IntCodec, UByteCodec, IntCodec, UByteCodec, UByteCodec, StringCodec, BooleanCodec> JoinGameFields;
+typedef PacketFields<UByteCodec> ServerDifficultyFields;
+typedef PacketFields<PositionCodec> SpawnPositionFields;
+typedef PacketFields<ByteCodec, FloatCodec, FloatCodec> PlayerAbilitiesFields;
+typedef PacketFields<PositionFCodec, FloatCodec, FloatCodec, ByteCodec, VarIntCodec> PlayerPositionAndLookFields;
+typedef PacketFields<IntCodec, IntCodec> UnloadChunkFields;
+typedef PacketFields<LongCodec> KeepAliveFields;
+
+// The biggest packet a client is allowed to send (the largest 3-byte VarInt)
+#define MAX_PACKET_SIZE 2097151
+
+/******************************************************
+ * NetworkHandler :: makePacketTable                  *
+ * Lays out how every packet a client sends is read,  *
+ * by the state it's sent in and its id. Packets with *
+ * a schema take their lengths from it, the rest give *
+ * the lengths their layout allows                    *
+ ******************************************************/
+constexpr NetworkHandler::PacketTable NetworkHandler::makePacketTable()
+{
+	PacketTable table = {};
+	auto add = [&table](ServerState state, Int packet, PacketReadFunction read, Int minLength, Int maxLength, const char* name)
+	{
+		table.handlers[(Int)state][packet] = { read, minLength, maxLength, name };
+	};
+
+	// Old clients' server list pings aren't framed, so receivePackets answers them before they get here
+	add(ServerState::Handshaking, (Int)ClientHandshakePacket::Handshake, &NetworkHandler::handShake, HandShakeSchema::minSize, HandShakeSchema::maxSize, "handShake");
+
+	add(ServerState::Status, (Int)ClientStatusPacket::Request, &NetworkHandler::request, 0, 0, "request");
+	add(ServerState::Status, (Int)ClientStatusPacket::Ping, &NetworkHandler::ping, PingSchema::minSize, PingSchema::maxSize, "ping");
+
+	add(ServerState::Login, (Int)ClientLoginPacket::LoginStart, &NetworkHandler::loginStart, LoginStartSchema::minSize, LoginStartSchema::maxSize, "loginStart");
+	add(ServerState::Login, (Int)ClientLoginPacket::EncryptionResponse, &NetworkHandler::encryptionResponse, 2, 2 * (2 + 256), "encryptionResponse"); // Two arrays, room for 2048 bit keys
+
+	add(ServerState::Play, (Int)ClientPlayPacket::TeleportConfirm, &NetworkHandler::teleportConfirm, TeleportConfirmSchema::minSize, TeleportConfirmSchema::maxSize, "teleportConfirm");
+	add(ServerState::Play, (Int)ClientPlayPacket::TabComplete, &NetworkHandler::tabComplete, TabCompleteSchema::minSize, TabCompleteSchema::maxSize + PositionCodec::size, "tabComplete");
+	add(ServerState::Play, (Int)ClientPlayPacket::ChatMessage, &NetworkHandler::chatMessage, ChatMessageSchema::minSize, ChatMessageSchema::maxSize, "chatMessage");
+	add(ServerState::Play, (Int)ClientPlayPacket::ClientStatus, &NetworkHandler::clientStatus, ClientStatusSchema::minSize, ClientStatusSchema::maxSize, "clientStatus");
+	add(ServerState::Play, (Int)ClientPlayPacket::ClientSettings, &NetworkHandler::clientSettings, ClientSettingsSchema::minSize, ClientSettingsSchema::maxSize, "clientSettings");
+	add(ServerState::Play, (Int)ClientPlayPacket::ConfirmTransaction, &NetworkHandler::confirmTransaction, ConfirmTransactionSchema::minSize, ConfirmTransactionSchema::maxSize, "confirmTransaction");
+	add(ServerState::Play, (Int)ClientPlayPacket::EnchantItem, &NetworkHandler::enchantItem, EnchantItemSchema::minSize, EnchantItemSchema::maxSize, "enchantItem");
+	add(ServerState::Play, (Int)ClientPlayPacket::ClickWindow, &NetworkHandler::clickWindow, 9, MAX_PACKET_SIZE, "clickWindow"); // The item's NBT can be any size
+	add(ServerState::Play, (Int)ClientPlayPacket::CloseWindow, &NetworkHandler::closeWindow, CloseWindowSchema::minSize, CloseWindowSchema::maxSize, "closeWindow");
+	add(ServerState::Play, (Int)ClientPlayPacket::PluginMessage, &NetworkHandler::pluginMessage, StringCodec::minSize, StringCodec::maxSize + 32767, "pluginMessage");
+	add(ServerState::Play, (Int)ClientPlayPacket::UseEntity, &NetworkHandler::useEntity, 2, 27, "useEntity");
+	add(ServerState::Play, (Int)ClientPlayPacket::KeepAlive, &NetworkHandler::keepAlive, KeepAliveSchema::minSize, KeepAliveSchema::maxSize, "keepAlive");
+	add(ServerState::Play, (Int)ClientPlayPacket::Player, &NetworkHandler::playerOnGround, PlayerOnGroundSchema::minSize, PlayerOnGroundSchema::maxSize, "playerOnGround");
+	add(ServerState::Play, (Int)ClientPlayPacket::PlayerPosition, &NetworkHandler::playerPosition, PlayerPositionSchema::minSize, PlayerPositionSchema::maxSize, "playerPosition");
+	add(ServerState::Play, (Int)ClientPlayPacket::PlayerPositionAndLook, &NetworkHandler::playerPositionAndLook, PlayerPositionAndLookSchema::minSize, PlayerPositionAndLookSchema::maxSize, "playerPositionAndLook");
+	add(ServerState::Play, (Int)ClientPlayPacket::PlayerLook, &NetworkHandler::playerLook, PlayerLookSchema::minSize, PlayerLookSchema::maxSize, "playerLook");
+	add(ServerState::Play, (Int)ClientPlayPacket::VehicleMove, &NetworkHandler::vehicleMove, 32, 32, "vehicleMove");
+	add(ServerState::Play, (Int)ClientPlayPacket::SteerBoat, &NetworkHandler::steerBoat, 2, 2, "steerBoat");
+	add(ServerState::Play, (Int)ClientPlayPacket::CraftRecipeRequest, &NetworkHandler::craftRecipeRequest, 3, 7, "craftRecipeRequest");
+	add(ServerState::Play, (Int)ClientPlayPacket::PlayerAbilities, &NetworkHandler::playerAbilities, 9, 9, "playerAbilities");
+	add(ServerState::Play, (Int)ClientPlayPacket::PlayerDigging, &NetworkHandler::playerDigging, 10, 14, "playerDigging");
+	add(ServerState::Play, (Int)ClientPlayPacket::EntityAction, &NetworkHandler::entityAction, 3, 15, "entityAction");
+	add(ServerState::Play, (Int)ClientPlayPacket::SteerVehicle, &NetworkHandler::steerVehicle, 9, 9, "steerVehicle");
+	add(ServerState::Play, (Int)ClientPlayPacket::CraftingBookData, &NetworkHandler::craftingBookData, 3, 9, "craftingBookData");
+	add(ServerState::Play, (Int)ClientPlayPacket::ResourcePackStatus, &NetworkHandler::resourcePackStatus, 1, 5, "resourcePackStatus");
+	add(ServerState::Play, (Int)ClientPlayPacket::AdvancementTab, &NetworkHandler::advancementTab, 1, VarIntCodec::maxSize + StringCodec::maxSize, "advancementTab");
+	add(ServerState::Play, (Int)ClientPlayPacket::HeldItemChange, &NetworkHandler::heldItemChange, 2, 2, "heldItemChange");
+	add(ServerState::Play, (Int)ClientPlayPacket::CreativeInventoryAction, &NetworkHandler::creativeInventoryAction, 4, MAX_PACKET_SIZE, "creativeInventoryAction"); // The item's NBT can be any size
+	add(ServerState::Play, (Int)ClientPlayPacket::UpdateSign, &NetworkHandler::updateSign, PositionCodec::size + 4 * StringCodec::minSize, PositionCodec::size + 4 * StringCodec::maxSize, "updateSign");
+	add(ServerState::Play, (Int)ClientPlayPacket::Animation, &NetworkHandler::animation, 1, 5, "animation");
+	add(ServerState::Play, (Int)ClientPlayPacket::Spectate, &NetworkHandler::spectate, 16, 16, "spectate");
+	add(ServerState::Play, (Int)ClientPlayPacket::PlayerBlockPlacement, &NetworkHandler::playerBlockPlacement, 22, 30, "playerBlockPlacement");
+	add(ServerState::Play, (Int)ClientPlayPacket::UseItem, &NetworkHandler::useItem, 1, 5, "useItem");
+	return table;
+}
+
+// Filled in at compile time rather than when the server starts (and a packet out of range fails to build)
+constinit const NetworkHandler::PacketTable NetworkHandler::packetTable = NetworkHandler::makePacketTable();
+
+/******************************************************
+ * inStatus                                           *
+ * Whether the client hasn't gotten past asking for   *
+ * the server's status, which the network threads     *
+ * answer on their own                                *
+ ******************************************************/
+Boolean inStatus(Client* client)
+{
+	return client->getState() == ServerState::Handshaking || client->getState() == ServerState::Status;
 }
 
-/*************************************************************
- * NetworkHandler :: readPacket                              *
- * Reads the packet and fires off any events it gets from it *
- *************************************************************/
-void NetworkHandler::readPacket(Client* client, Byte* const buffer, Int length, Boolean deleteBuffer)
+/*****************************************************************
+ * NetworkHandler :: receivePackets                              *
+ * Adds the data to what the client already sent and reads every *
+ * packet that has fully arrived. Whatever is left of a packet   *
+ * split across several reads waits for the rest of it           *
+ *****************************************************************/
+void NetworkHandler::receivePackets(Client* client, const Byte* data, Int length)
 {
-	// Read the length of the packet
-	Byte* buf = buffer;
-	VarInt varLen = VarInt(buf);
+	RingBuffer& received = client->received;
+	if (length > 0)
+		received.append(data, length);
 
-	// Read the packet's id
-	buf += varLen.getSize();
-	VarInt varPack = VarInt(buf);
-
-	// Calculate the length of the buffer minus the length
-	// of the length and packet id variables themselves
-	Int len = varLen.toInt() - varLen.getSize() - varPack.getSize();
-	buf += varPack.getSize();
-
-	// Check which state the client is currently in
-	int packid = varPack.toInt();
-	std::cout << client->getName() << ": 0x" << std::hex << packid << " - " << std::dec << len << " bytes\n";
-	switch (client->getState())
+	// Old clients ping without the length in front, so the packet is whatever they sent
+	if (client->getState() == ServerState::Handshaking && (UByte)received[0] == (UByte)ClientHandshakePacket::LegacyServerPing)
+	{
+		Int size = received.size();
+		handShakeLegacy(client, received.peek(size) + 1, size - 1);
+		received.clear();
+		return;
+	}
+
+	while (!received.empty())
 	{
-	case ServerState::Handshaking:
-		// Check which packet the client was referring to
-		switch (packid)
+		// Read the length of the packet, if all of it arrived
+		Int packetLength = 0;
+		Int lengthSize = 0;
+		Byte read;
+		do
+		{
+			if (lengthSize >= received.size())
+				return;
+
+			read = received[lengthSize];
+			packetLength |= (read & 0x7f) << (7 * lengthSize);
+			lengthSize++;
+		} while ((read & 0x80) != 0 && lengthSize < 3);
+
+		// If the length makes no sense then the stream can't be read anymore
+		if ((read & 0x80) != 0 || packetLength < 1 || packetLength > MAX_PACKET_SIZE)
 		{
-		case (int)ClientHandshakePacket::Handshake:
-			handShake(client, buf, len);
-			break;
-		case (int)ClientHandshakePacket::LegacyServerPing:
-			handShakeLegacy(client, buf, len);
-			break;
-		default:	// Invalid Packet
-			invalidPacket(client, buf, len, packid);
-			break;
+			invalidLength(client, packetLength, "receivePackets");
+			received.clear();
+			return;
 		}
-		break;
-	case ServerState::Status:
-		switch (packid)
+
+		// Wait for the rest of the packet, making sure there's room for it when it comes
+		if (received.size() < lengthSize + packetLength)
 		{
-		case (int)ClientStatusPacket::Request:
-			request(client, buf, len);
-			break;
-		case (int)ClientStatusPacket::Ping:
-			ping(client, buf, len);
-			break;
-		default:	// Invalid Packet
-			invalidPacket(client, buf, len, packid);
-			break;
+			received.reserve(lengthSize + packetLength);
+			return;
 		}
-		break;
-	case ServerState::Login:
-		switch (packid)
+
+		// Read the packet straight out of the buffer, dropping the rest of the stream if it can't be read anymore
+		received.consume(lengthSize);
+		Boolean readable;
+		if (client->getCompressionThreshold() >= 0)
+			readable = readCompressedPacket(client, received.peek(packetLength), packetLength);
+		else
+			readable = readPacket(client, received.peek(packetLength), packetLength);
+		if (!readable)
 		{
-		case (int)ClientLoginPacket::LoginStart:
-			loginStart(client, buf, len);
-			break;
-		case (int)ClientLoginPacket::EncryptionResponse:
-			encryptionResponse(client, buf, len);
-			break;
-		default:	// Invalid Packet
-			invalidPacket(client, buf, len, packid);
-			break;
+			received.clear();
+			return;
 		}
-		break;
-	case ServerState::Play:
-		switch (packid)
+		received.consume(packetLength);
+	}
+}
+
+/*************************************************************
+ * NetworkHandler :: readCompressedPacket                    *
+ * Inflates a packet sent in the compressed format (if it    *
+ * was actually deflated) and reads it                       *
+ * Returns false if the client's stream can't be read past   *
+ * it anymore                                                *
+ *************************************************************/
+Boolean NetworkHandler::readCompressedPacket(Client* client, Byte* buffer, Int length)
+{
+	// Read how big the packet is once it's inflated
+	Int dataLength = 0;
+	Int lengthSize = 0;
+	Byte read;
+	do
+	{
+		if (lengthSize >= length)
 		{
-		case (int)ClientPlayPacket::TeleportConfirm:
-			teleportConfirm(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::TabComplete:
-			tabComplete(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::ChatMessage:
-			chatMessage(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::ClientStatus:
-			clientStatus(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::ClientSettings:
-			clientSettings(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::ConfirmTransaction:
-			confirmTransaction(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::EnchantItem:
-			enchantItem(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::ClickWindow:
-			clickWindow(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::CloseWindow:
-			closeWindow(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::PluginMessage:
-			pluginMessage(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::UseEntity:
-			useEntity(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::KeepAlive:
-			keepAlive(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::PlayerPosition:
-			playerPosition(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::PlayerPositionAndLook:
-			playerPositionAndLook(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::PlayerLook:
-			playerLook(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::Player:
-			playerOnGround(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::VehicleMove:
-			vehicleMove(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::SteerBoat:
-			steerBoat(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::CraftRecipeRequest:
-			craftRecipeRequest(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::PlayerAbilities:
-			playerAbilities(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::PlayerDigging:
-			playerDigging(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::EntityAction:
-			entityAction(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::SteerVehicle:
-			steerVehicle(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::CraftingBookData:
-			craftingBookData(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::ResourcePackStatus:
-			resourcePackStatus(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::AdvancementTab:
-			advancementTab(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::HeldItemChange:
-			heldItemChange(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::CreativeInventoryAction:
-			creativeInventoryAction(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::UpdateSign:
-			updateSign(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::Animation:
-			animation(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::Spectate:
-			spectate(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::PlayerBlockPlacement:
-			playerBlockPlacement(client, buf, len);
-			break;
-		case (int)ClientPlayPacket::UseItem:
-			useItem(client, buf, len);
-			break;
-		default:	// Invalid Packet
-			invalidPacket(client, buf, len, packid);
-			break;
+			invalidLength(client, length, "readCompressedPacket");
+			return false;
 		}
-		break;
-	default:	// Invalid Client State
-		invalidState(client, buf, len);
-		break;
+
+		read = buffer[lengthSize];
+		dataLength |= (read & 0x7f) << (7 * lengthSize);
+		lengthSize++;
+	} while ((read & 0x80) != 0 && lengthSize < 3);
+
+	// A length of zero means that the packet was too small to bother deflating
+	if ((read & 0x80) == 0 && dataLength == 0)
+	{
+		return readPacket(client, buffer + lengthSize, length - lengthSize);
+	}
+
+	// Inflate the packet into a buffer the thread keeps around for it
+	static thread_local std::vector<Byte> inflated;
+	if ((read & 0x80) != 0 || dataLength > MAX_PACKET_SIZE)
+	{
+		invalidLength(client, dataLength, "readCompressedPacket");
+		return false;
+	}
+	inflated.resize(dataLength);
+	if (!inflateData(buffer + lengthSize, length - lengthSize, inflated.data(), dataLength))
+	{
+		invalidLength(client, dataLength, "inflateData");
+		return false;
+	}
+
+	return readPacket(client, inflated.data(), dataLength);
+}
+
+/*************************************************************
+ * NetworkHandler :: readPacket                              *
+ * Reads the packet and fires off any events it gets from it *
+ * Returns false if the client's stream can't be read past   *
+ * it anymore (a bad packet only costs the client that one)  *
+ *************************************************************/
+Boolean NetworkHandler::readPacket(Client* client, Byte* buffer, Int length)
+{
+	// Read the packet's id
+	PacketReader reader(buffer, length);
+	int packid = reader.readVarInt();
+	if (reader.hasFailed())
+	{
+		invalidPacket(client, buffer, length, -1);
+		return true;
 	}
 
-	// Assume what's left over in the packet is another packet
-	Int tempLen = len + varPack.getSize() + (varLen.getSize() * 2);
+	// Calculate the length of the buffer minus the length of the packet id
+	Int len = reader.getRemaining();
+	Byte* buf = buffer + (length - len);
 
-	// If the packet's length is smaller than reality allows then complain
-	// TODO: Check for an invalid packet while reading! This will LEAK MEMORY
-	if (tempLen < 1)
+	// Look the packet up by the client's current state and its id
+	Int state = (Int)client->getState();
+	if (state < 0 || state >= PACKET_STATES)
+	{
+		invalidState(client, buf, len);
+		return true;
+	}
+	if (packid < 0 || packid >= PACKET_ID_LIMIT || packetTable.handlers[state][packid].read == NULL)
 	{
-		std::cout << "Error: Erroneous packet from " << client->getName()
-			      << ": Has a length of " << tempLen << " bytes.\n"
-				  << "\tExpected a length of " << length << " bytes.\n";
+		invalidPacket(client, buf, len, packid);
+		return true;
 	}
-	else if (tempLen < length)
+	const PacketHandler& handler = packetTable.handlers[state][packid];
+	PacketCounters& counters = client->networkThread->packets[state][packid];
+
+	// Turn away packets that can't be the length they are before anything reads them
+	if (len < handler.minLength || len > handler.maxLength)
 	{
-		// Create another array for the next packet
-		// TODO: Save on copying data maybe?
-		buf = buffer + tempLen;
-		length -= tempLen;
-		Byte* tempBuf = new Byte[length];
-		for (int i = 0; i < length; i++)
-			tempBuf[i] = buf[i];
-
-		// Read the next packet
-		readPacket(client, tempBuf, length, true);
+		counters.rejected.store(counters.rejected.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		malformedPacket(client, len, handler.name);
+		return true;
 	}
 
-	// If we're supposed to, delete the buffer
-	if (deleteBuffer)
-		delete[] buffer;
+	// Only this thread counts its packets, so there's no need for the counters to be locked
+	counters.count.store(counters.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	counters.bytes.store(counters.bytes.load(std::memory_order_relaxed) + len, std::memory_order_relaxed);
+	(this->*handler.read)(client, buf, len);
+	return true;
+}
+
+/*************************************************************
+ * NetworkHandler :: getPacketMetrics                        *
+ * How many of the packet every network thread has read so  *
+ * far                                                       *
+ *************************************************************/
+PacketMetrics NetworkHandler::getPacketMetrics(ServerState state, Int packetID)
+{
+	PacketMetrics metrics = { 0, 0, 0 };
+	if ((Int)state < 0 || (Int)state >= PACKET_STATES || packetID < 0 || packetID >= PACKET_ID_LIMIT)
+		return metrics;
+
+	for (size_t i = 0; i < threads.size(); ++i)
+	{
+		PacketCounters& counters = threads[i]->packets[(Int)state][packetID];
+		metrics.count += counters.count.load(std::memory_order_relaxed);
+		metrics.bytes += counters.bytes.load(std::memory_order_relaxed);
+		metrics.rejected += counters.rejected.load(std::memory_order_relaxed);
+	}
+	return metrics;
 }
 
 /*************************************
@@ -362,11 +640,11 @@ void NetworkHandler::invalidPacket(Client* client, Byte* buffer, Int length, Int
 	e.client = client;
 	e.packetID = packet;
 	e.dataLength = length;
-	e.data = copyBuffer(buffer, length);
 
-	// Trigger the event before deleting the associated data
-	eventHandler->invalidPacket(e);
-	delete[] e.data;
+	// Hand the event to the server thread along with the packet
+	EventQueue::Writer batch(client->networkThread->events);
+	e.data = batch->keep(buffer, length);
+	batch->push<EventID::invalidPacket>(e);
 }
 
 /*************************************
@@ -379,7 +657,78 @@ void NetworkHandler::invalidState(Client* client, Byte* buffer, Int length)
 	InvalidStateEventArgs e;
 	e.client = client;
 	e.state = client->getState();
-	eventHandler->invalidState(e);
+	EventQueue::Writer(client->networkThread->events)->push<EventID::invalidState>(e);
+}
+
+/**********************************************
+ * NetworkHandler :: invalidLength            *
+ * The client sent a length that makes no     *
+ * sense, so the rest of its stream can't be  *
+ * read anymore                               *
+ **********************************************/
+void NetworkHandler::invalidLength(Client* client, Int length, String cause)
+{
+	InvalidLengthEventArgs e;
+	e.client = client;
+	e.eventCause = cause;
+	e.e = NULL;
+	e.length = length;
+	EventQueue::Writer(client->networkThread->events)->push<EventID::invalidLength>(e);
+
+	// Have the network thread disconnect the client (whoever is reading its stream drops the rest of it)
+	shutdown(client->getSocket(), SD_BOTH);
+}
+
+/**********************************************
+ * NetworkHandler :: malformedPacket          *
+ * The client sent a packet whose data can't  *
+ * be as long as it is, which is dropped      *
+ * without being read                         *
+ **********************************************/
+void NetworkHandler::malformedPacket(Client* client, Int length, const char* cause)
+{
+	InvalidLengthEventArgs e;
+	e.client = client;
+	e.eventCause = cause;
+	e.e = NULL;
+	e.length = length;
+	EventQueue::Writer(client->networkThread->events)->push<EventID::invalidLength>(e);
+}
+
+/**********************************************
+ * NetworkHandler :: truncatedPacket          *
+ * The client sent a packet that's too short  *
+ * for its fields, which only costs it that   *
+ * packet. The batch keeps a copy of what was *
+ * read for the server to look at             *
+ **********************************************/
+template<typename Args>
+void NetworkHandler::truncatedPacket(EventBatch& batch, Int length, const char* cause, const Args& e)
+{
+	InvalidLengthEventArgs e2;
+	e2.client = e.client;
+	e2.eventCause = cause;
+	e2.e = batch.copy(e);
+	e2.length = length;
+	batch.push<EventID::invalidLength>(e2);
+}
+
+/**********************************************
+ * NetworkHandler :: queueEvent               *
+ * Hands the event to the server thread (or   *
+ * an invalid length event if the packet was  *
+ * too short), copying the text that the      *
+ * given members point to along with it       *
+ **********************************************/
+template<EventID Event, typename Args, typename... Views>
+void NetworkHandler::queueEvent(Client* client, Int length, const char* cause, Args& e, Boolean valid, Views... views)
+{
+	EventQueue::Writer batch(client->networkThread->events);
+	((e.*views = batch->keep(e.*views)), ...);
+	if (valid)
+		batch->push<Event>(e);
+	else
+		truncatedPacket(*batch, length, cause, e);
 }
 
 /***********************************
@@ -388,23 +737,19 @@ void NetworkHandler::invalidState(Client* client, Byte* buffer, Int length)
  ***********************************/
 void NetworkHandler::handShake(Client* client, Byte* buffer, Int length)
 {
-	// Read the protocol from the buffer
+	// Read the packet
 	HandShakeEventArgs e;
 	e.client = client;
-	VarInt protocol = VarInt(buffer);
-	e.protocolVersion = protocol.toInt();
-	buffer += protocol.getSize();
-
-	// Read the server address and port
-	SerialString address = SerialString(buffer);
-	e.serverAddress = address.str();
-	buffer += address.getSize();
-	e.serverPort = parseShort(buffer);
-	buffer += 2; // 2 bytes (short)
+	if (!HandShakeSchema::read(buffer, length, e))
+	{
+		EventQueue::Writer batch(client->networkThread->events);
+		e.serverAddress = batch->keep(e.serverAddress);
+		truncatedPacket(*batch, length, "handShake", e);
+		return;
+	}
 
-	// Trigger the server's handshake event
-	e.state = (ServerState)VarInt(buffer).toInt();
-	eventHandler->handshake(e);
+	// Trigger the server's handshake event right away, since it decides how the next packet is read
+	eventHandler->getDispatch().handshake(eventHandler, e);
 }
 
 /****************************************
@@ -415,10 +760,10 @@ void NetworkHandler::handShakeLegacy(Client* client, Byte* buffer, Int length)
 {
 	LegacyServerListPingEventArgs e;
 	e.client = client;
-	e.payload = *buffer;
+	e.payload = length > 0 ? *buffer : 0; // The oldest clients don't send a payload
 
 	// Trigger the server's legacy server list ping event
-	eventHandler->legacyServerListPing(e);
+	eventHandler->getDispatch().legacyServerListPing(eventHandler, e);
 }
 
 /*****************************************
@@ -427,10 +772,10 @@ void NetworkHandler::handShakeLegacy(Client* client, Byte* buffer, Int length)
  *****************************************/
 void NetworkHandler::request(Client* client, Byte* buffer, Int length)
 {
-	// Alert the server of the client's request
-	RequestEventArgs e;
-	e.client = client;
-	eventHandler->request(e);
+	// Send the status the server already has ready
+	std::shared_ptr<const String> response = status.getResponse();
+	client->outbound.push(response);
+	flushClient(client);
 }
 
 /************************************
@@ -439,11 +784,17 @@ void NetworkHandler::request(Client* client, Byte* buffer, Int length)
  ************************************/
 void NetworkHandler::ping(Client* client, Byte* buffer, Int length)
 {
-	// Alert the server of the client's ping
+	// Read the packet
 	PingEventArgs e;
 	e.client = client;
-	e.payload = parseLong(buffer);
-	eventHandler->ping(e);
+	if (!PingSchema::read(buffer, length, e))
+	{
+		truncatedPacket(*EventQueue::Writer(client->networkThread->events), length, "ping", e);
+		return;
+	}
+
+	// Alert the server of the client's ping
+	sendPong(client, e.payload);
 }
 
 
@@ -453,14 +804,13 @@ void NetworkHandler::ping(Client* client, Byte* buffer, Int length)
  ***************************************/
 void NetworkHandler::loginStart(Client* client, Byte* buffer, Int length)
 {
-	// Get the player's username
-	LoginStartEventArgs e = LoginStartEventArgs();
-	SerialString name = SerialString(buffer);
+	// Read the packet
+	LoginStartEventArgs e;
 	e.client = client;
-	e.name = name.str();
+	Boolean valid = LoginStartSchema::read(buffer, length, e);
 
 	// Prompt the server to let the client in
-	eventHandler->loginStart(e);
+	queueEvent<EventID::loginStart>(client, length, "loginStart", e, valid, &LoginStartEventArgs::name);
 }
 
 
@@ -470,30 +820,27 @@ void NetworkHandler::loginStart(Client* client, Byte* buffer, Int length)
  ************************************************************************/
 void NetworkHandler::encryptionResponse(Client* client, Byte* buffer, Int length)
 {
-	// Get the shared secret's length
+	// Get the shared secret and the verify token
 	EncryptionResponseEventArgs e;
 	e.client = client;
-	VarInt sharedSecretLen = VarInt(buffer);
-	e.sharedSecretLen = sharedSecretLen.toInt();
-	buffer += sharedSecretLen.getSize();
-
-	// Get the shared secret's data
-	e.sharedSecret = copyBuffer(buffer, e.sharedSecretLen);
-	buffer += e.sharedSecretLen;
-
-	// Get the verify token's length
-	VarInt verifyTokenLen = VarInt(buffer);
-	e.verifyTokenLen = verifyTokenLen.toInt();
-	buffer += verifyTokenLen.getSize();
+	PacketReader reader(buffer, length);
+	e.sharedSecretLen = reader.readVarInt();
+	const Byte* sharedSecret = e.sharedSecretLen >= 0 ? reader.take(e.sharedSecretLen) : NULL;
+	e.verifyTokenLen = reader.readVarInt();
+	const Byte* verifyToken = e.verifyTokenLen >= 0 ? reader.take(e.verifyTokenLen) : NULL;
+	e.sharedSecret = NULL;
+	e.verifyToken = NULL;
+	EventQueue::Writer batch(client->networkThread->events);
+	if (!sharedSecret || !verifyToken)
+	{
+		truncatedPacket(*batch, length, "encryptionResponse", e);
+		return;
+	}
 
-	// Get the verify token's data
-	e.verifyToken = copyBuffer(buffer, e.verifyTokenLen);
-	
-	// Notify the server of the client's response before deleting the associated data
-	EventHandler* handler = eventHandler;
-	eventHandler->encryptionResponse(e);
-	delete[] e.sharedSecret;
-	delete[] e.verifyToken;
+	// Notify the server of the client's response, along with a copy of the associated data
+	e.sharedSecret = batch->keep(sharedSecret, e.sharedSecretLen);
+	e.verifyToken = batch->keep(verifyToken, e.verifyTokenLen);
+	batch->push<EventID::encryptionResponse>(e);
 }
 
 /*****************************************
@@ -502,13 +849,13 @@ void NetworkHandler::encryptionResponse(Client* client, Byte* buffer, Int length
  *****************************************/
 void NetworkHandler::teleportConfirm(Client* client, Byte* buffer, Int length)
 {
-	// Get the teleport's id
+	// Read the packet
 	TeleportConfirmEventArgs e;
 	e.client = client;
-	e.teleportID = VarInt(buffer).toInt();
+	Boolean valid = TeleportConfirmSchema::read(buffer, length, e);
 
 	// Alert the server of the client's confirmation
-	eventHandler->teleportConfirm(e);
+	queueEvent<EventID::teleportConfirm>(client, length, "teleportConfirm", e, valid);
 }
 
 /****************************************************
@@ -517,23 +864,18 @@ void NetworkHandler::teleportConfirm(Client* client, Byte* buffer, Int length)
  ****************************************************/
 void NetworkHandler::tabComplete(Client* client, Byte* buffer, Int length)
 {
-	// Get the text
+	// Get the text, assumeCommand and hasPosition
 	TabCompleteEventArgs e;
 	e.client = client;
-	SerialString text = SerialString(buffer);
-	e.text = text.str();
-	buffer += text.getSize();
-
-	// Get assumeCommand and hasPosition
-	e.assumeCommand = !!*(buffer++);
-	e.hasPosition = !!*(buffer++);
+	PacketReader reader(buffer, length);
+	Boolean valid = TabCompleteSchema::read(reader, e);
 
 	// If there was a position given, get the coordinates
-	if (e.hasPosition)
-		e.lookedAtBlock = SerialPosition(parseLong(buffer)).toPosition();
+	if (valid && e.hasPosition)
+		valid = readValue<PositionCodec>(reader, e.lookedAtBlock);
 
 	// Send the information to the server
-	eventHandler->tabComplete(e);
+	queueEvent<EventID::tabComplete>(client, length, "tabComplete", e, valid, &TabCompleteEventArgs::text);
 }
 
 /*****************************************
@@ -542,13 +884,13 @@ void NetworkHandler::tabComplete(Client* client, Byte* buffer, Int length)
  *****************************************/
 void NetworkHandler::chatMessage(Client* client, Byte* buffer, Int length)
 {
-	// Get the text
+	// Read the packet
 	ChatMessageEventArgs e;
 	e.client = client;
-	e.message = SerialString(buffer).str();
+	Boolean valid = ChatMessageSchema::read(buffer, length, e);
 
 	// Send the data to the server for interpreting / broadcasting
-	eventHandler->chatMessage(e);
+	queueEvent<EventID::chatMessage>(client, length, "chatMessage", e, valid, &ChatMessageEventArgs::message);
 }
 
 /************************************************************************
@@ -557,13 +899,13 @@ void NetworkHandler::chatMessage(Client* client, Byte* buffer, Int length)
  ************************************************************************/
 void NetworkHandler::clientStatus(Client* client, Byte* buffer, Int length)
 {
-	// Get the client's intent
+	// Read the packet
 	ClientStatusEventArgs e;
 	e.client = client;
-	e.action = (ClientStatusAction)VarInt(buffer).toInt();
+	Boolean valid = ClientStatusSchema::read(buffer, length, e);
 
 	// Send the event to the server
-	eventHandler->clientStatus(e);
+	queueEvent<EventID::clientStatus>(client, length, "clientStatus", e, valid);
 }
 
 /*****************************************************
@@ -572,32 +914,13 @@ void NetworkHandler::clientStatus(Client* client, Byte* buffer, Int length)
  *****************************************************/
 void NetworkHandler::clientSettings(Client* client, Byte* buffer, Int length)
 {
-	// Get the client's locale
+	// Read the packet
 	ClientSettingsEventArgs e;
 	e.client = client;
-	SerialString locale = SerialString(buffer);
-	e.locale = locale.str();
-	buffer += locale.getSize();
-
-	// Get the client's view distance
-	e.viewDistance = *(buffer++);
-
-	// Get the client's chat mode
-	VarInt chatMode = VarInt(buffer);
-	e.chatMode = (ChatMode)chatMode.toInt();
-	buffer += chatMode.getSize();
-
-	// Get the client's chat colors setting
-	e.chatColors = !!*(buffer++);
-
-	// Get the client's displayed skin parts
-	e.displayedSkinParts = DisplayedSkinParts(*(buffer++));
-
-	// Get the client's main hand
-	e.mainHand = (MainHand)VarInt(buffer).toInt();
+	Boolean valid = ClientSettingsSchema::read(buffer, length, e);
 
 	// Notify the server of the client's requested settings
-	eventHandler->clientSettings(e);
+	queueEvent<EventID::clientSettings>(client, length, "clientSettings", e, valid, &ClientSettingsEventArgs::locale);
 }
 
 /*******************************************************************
@@ -606,20 +929,13 @@ void NetworkHandler::clientSettings(Client* client, Byte* buffer, Int length)
  *******************************************************************/
 void NetworkHandler::confirmTransaction(Client* client, Byte* buffer, Int length)
 {
-	// Get the window id
+	// Read the packet
 	ConfirmTransactionEventArgs e;
 	e.client = client;
-	e.windowID = *(buffer++);
-
-	// Get the action number
-	e.actionNum = parseShort(buffer);
-	buffer += 2;
-
-	// Get whether the transaction was accepted
-	e.accepted = !!*buffer;
+	Boolean valid = ConfirmTransactionSchema::read(buffer, length, e);
 
 	// Notify the server of the client's confirmation
-	eventHandler->confirmTransaction(e);
+	queueEvent<EventID::confirmTransaction>(client, length, "confirmTransaction", e, valid);
 }
 
 /***************************************
@@ -628,14 +944,13 @@ void NetworkHandler::confirmTransaction(Client* client, Byte* buffer, Int length
  ***************************************/
 void NetworkHandler::enchantItem(Client* client, Byte* buffer, Int length)
 {
-	// Get the window id and enchantment
+	// Read the packet
 	EnchantItemEventArgs e;
 	e.client = client;
-	e.windowID = *(buffer++);
-	e.enchantment = (EnchantmentPos)*buffer;
+	Boolean valid = EnchantItemSchema::read(buffer, length, e);
 
 	// Notify the server that the client wants to enchant an item
-	eventHandler->enchantItem(e);
+	queueEvent<EventID::enchantItem>(client, length, "enchantItem", e, valid);
 }
 
 /*******************************************
@@ -653,13 +968,13 @@ void NetworkHandler::clickWindow(Client* client, Byte* buffer, Int length)
  **************************************/
 void NetworkHandler::closeWindow(Client* client, Byte* buffer, Int length)
 {
-	// Get the window id
+	// Read the packet
 	CloseWindowEventArgs e;
 	e.client = client;
-	e.windowID = *buffer;
+	Boolean valid = CloseWindowSchema::read(buffer, length, e);
 
 	// Tell the server the client wants to close the window
-	eventHandler->closeWindow(e);
+	queueEvent<EventID::closeWindow>(client, length, "closeWindow", e, valid);
 }
 
 /**********************************************************************************
@@ -671,30 +986,24 @@ void NetworkHandler::pluginMessage(Client* client, Byte* buffer, Int length)
 	// Get the channel of the plugin message
 	PluginMessageEventArgs e;
 	e.client = client;
-	SerialString channel = SerialString(buffer);
-	e.channel = channel.str();
-	buffer += channel.getSize();
-	e.length = length - channel.getSize();
-
-	// If the length is not long enough for the data then notify the server of an error
-	if (e.length < 0)
+	e.data = NULL;
+	PacketReader reader(buffer, length);
+	e.channel = reader.readStringView();
+	e.length = reader.getRemaining();
+
+	// If the length is not long enough for the channel then notify the server of an error
+	const Byte* data = reader.take(e.length);
+	EventQueue::Writer batch(client->networkThread->events);
+	e.channel = batch->keep(e.channel);
+	if (!data)
 	{
-		InvalidLengthEventArgs e2;
-		e2.client = client;
-		e2.eventCause = "pluginMessage";
-		e2.e = &e;
-		e2.length = e.length;
-		eventHandler->invalidLength(e2);
+		truncatedPacket(*batch, length, "pluginMessage", e);
 		return;
 	}
 
-	// Get the message's data
-	e.data = copyBuffer(buffer, e.length);
-
-	// Tell the server the client is sending a plugin message
-	EventHandler* handler = eventHandler;
-	eventHandler->pluginMessage(e);
-	delete[] e.data;
+	// Tell the server the client is sending a plugin message, along with a copy of the message's data
+	e.data = batch->keep(data, e.length);
+	batch->push<EventID::pluginMessage>(e);
 }
 
 /*******************************************
@@ -712,11 +1021,13 @@ void NetworkHandler::useEntity(Client* client, Byte* buffer, Int length)
  ***********************************************************/
 void NetworkHandler::keepAlive(Client* client, Byte* buffer, Int length)
 {
-	// Parse the packet, a single int
+	// Read the packet
 	KeepAliveEventArgs e;
 	e.client = client;
-	e.id = parseInt(buffer);
-	eventHandler->keepAlive(e);
+	Boolean valid = KeepAliveSchema::read(buffer, length, e);
+
+	// Alert the server of the client's response
+	queueEvent<EventID::keepAlive>(client, length, "keepAlive", e, valid);
 }
 
 /*********************************************
@@ -725,18 +1036,13 @@ void NetworkHandler::keepAlive(Client* client, Byte* buffer, Int length)
  *********************************************/
 void NetworkHandler::playerPosition(Client* client, Byte* buffer, Int length)
 {
-	// Get the position
+	// Read the packet
 	PlayerPositionEventArgs e;
 	e.client = client;
-	e.position.x = parseDouble(buffer);
-	e.position.y = parseDouble(buffer += 8);
-	e.position.z = parseDouble(buffer += 8);
-
-	// Determine if the client is on the floor
-	e.onGround = !!*(buffer += 8);
+	Boolean valid = PlayerPositionSchema::read(buffer, length, e);
 
 	// Trigger the event
-	eventHandler->playerPosition(e);
+	queueEvent<EventID::playerPosition>(client, length, "playerPosition", e, valid);
 }
 
 /*******************************************************
@@ -745,22 +1051,13 @@ void NetworkHandler::playerPosition(Client* client, Byte* buffer, Int length)
  *******************************************************/
 void NetworkHandler::playerPositionAndLook(Client* client, Byte* buffer, Int length)
 {
-	// Get the position
+	// Read the packet
 	PlayerPositionAndLookEventArgs e;
 	e.client = client;
-	e.position.x = parseDouble(buffer);
-	e.position.y = parseDouble(buffer += 8);
-	e.position.z = parseDouble(buffer += 8);
-
-	// Get the head angle
-	e.yaw = parseFloat(buffer += 8);
-	e.pitch = parseFloat(buffer += 4);
-
-	// Determine if the client is on the floor
-	e.onGround = !!*(buffer += 4);
+	Boolean valid = PlayerPositionAndLookSchema::read(buffer, length, e);
 
 	// Trigger the event
-	eventHandler->playerPositionAndLook(e);
+	queueEvent<EventID::playerPositionAndLook>(client, length, "playerPositionAndLook", e, valid);
 }
 
 /**************************************************
@@ -769,17 +1066,13 @@ void NetworkHandler::playerPositionAndLook(Client* client, Byte* buffer, Int len
  **************************************************/
 void NetworkHandler::playerLook(Client* client, Byte* buffer, Int length)
 {
-	// Get the head angle
+	// Read the packet
 	PlayerLookEventArgs e;
 	e.client = client;
-	e.yaw = parseFloat(buffer);
-	e.pitch = parseFloat(buffer += 4);
-
-	// Determine if the client is on the floor
-	e.onGround = !!*(buffer += 4);
+	Boolean valid = PlayerLookSchema::read(buffer, length, e);
 
 	// Trigger the event
-	eventHandler->playerLook(e);
+	queueEvent<EventID::playerLook>(client, length, "playerLook", e, valid);
 }
 
 /**************************************************************
@@ -788,13 +1081,13 @@ void NetworkHandler::playerLook(Client* client, Byte* buffer, Int length)
  **************************************************************/
 void NetworkHandler::playerOnGround(Client* client, Byte* buffer, Int length)
 {
-	// Determine if the client is on the floor
+	// Read the packet
 	PlayerOnGroundEventArgs e;
 	e.client = client;
-	e.onGround = !!*buffer;
+	Boolean valid = PlayerOnGroundSchema::read(buffer, length, e);
 
 	// Trigger the event
-	eventHandler->playerOnGround(e);
+	queueEvent<EventID::playerOnGround>(client, length, "playerOnGround", e, valid);
 }
 
 /**************************************
@@ -955,6 +1248,50 @@ void NetworkHandler::useItem(Client* client, Byte* buffer, Int length)
 
 }
 
+/********************************************
+ * NetworkHandler :: sendResponse           *
+ * Tell the client the server's status      *
+ ********************************************/
+void NetworkHandler::sendResponse(Client* client, String json)
+{
+	// Serialize the data
+	PacketWriter packet((Int)ServerStatusPacket::Response);
+	packet.writeString(json);
+
+	// Send the packet
+	sendPacket(client, packet);
+}
+
+/********************************************
+ * NetworkHandler :: sendPong               *
+ * Answer the client's ping right away      *
+ ********************************************/
+void NetworkHandler::sendPong(Client* client, Long payload)
+{
+	// Serialize the data
+	PacketWriter packet((Int)ServerStatusPacket::Pong);
+	PongFields::write(packet, payload);
+
+	// Send the packet, without waiting for the end of the tick since it's being timed
+	sendPacket(client, packet);
+	flushClient(client);
+}
+
+/*****************************************
+ * writeChatMessage                      *
+ * Serializes a chat message's data      *
+ *****************************************/
+void writeChatMessage(PacketWriter& packet, const String& message, ChatMessageType type, Boolean isJson)
+{
+	// If the text is in JSON format then send it directly
+	if (isJson)
+		packet.writeString(message);
+	// If the text is not in JSON then make it so.
+	else
+		packet.writeString(String("{ \"text\": \"") + message + String("\" }"));
+	packet.writeByte((Byte)type);
+}
+
 /***************************************************
  * NetworkHandler :: sendLoginSuccess              *
  * Tell the client that their login was successful *
@@ -962,21 +1299,30 @@ void NetworkHandler::useItem(Client* client, Byte* buffer, Int length)
 void NetworkHandler::sendLoginSuccess(Client* client, UUID uuid, String username)
 {
 	// Serialize the data
-	String data;
-	VarInt packid = VarInt((Int)ServerLoginPacket::LoginSuccess);
-	SerialString suuid = SerialString(uuid.str());
-	SerialString susername = SerialString(username);
-	VarInt length = VarInt(packid.getSize() + suuid.getSize() + susername.getSize());
-	data.reserve(length.toInt() + length.getSize());
-
-	// Append the data to the string
-	data.append((char*)length.getData(), length.getSize());
-	data.append((char*)packid.getData(), packid.getSize());
-	data.append(suuid.makeData(), suuid.getSize());
-	data.append(susername.makeData(), susername.getSize());
+	PacketWriter packet((Int)ServerLoginPacket::LoginSuccess);
+	packet.writeString(uuid.str());
+	packet.writeString(username);
+
+	// Send the packet
+	sendPacket(client, packet);
+}
+
+/*****************************************************
+ * NetworkHandler :: sendSetCompression              *
+ * Tell the client to compress every packet at least *
+ * maxPacketSize bytes big from now on               *
+ *****************************************************/
+void NetworkHandler::sendSetCompression(Client* client, Int maxPacketSize)
+{
+	// Serialize the data
+	PacketWriter packet((Int)ServerLoginPacket::SetCompression);
+	SetCompressionFields::write(packet, maxPacketSize);
 
 	// Send the packet
-	send(client->getSocket(), data.c_str(), data.size(), NULL);
+	sendPacket(client, packet);
+
+	// Every packet after this one is in the compressed format, both ways
+	client->setCompressionThreshold(maxPacketSize);
 }
 
 /*************************************
@@ -986,28 +1332,25 @@ void NetworkHandler::sendLoginSuccess(Client* client, UUID uuid, String username
 void NetworkHandler::sendChatMessage(Client* client, String message, ChatMessageType type, Boolean isJson)
 {
 	// Serialize the data
-	String data;
-	VarInt packid = VarInt((Int)ServerPlayPacket::ChatMessage);
-	SerialString smessage;
-
-	// If the text is in JSON format then send it directly
-	if (isJson)
-		smessage = SerialString(message);
-	// If the text is not in JSON then make it so.
-	else
-		smessage = SerialString(String("{ \"text\": \"") + message + String("\" }"));
+	PacketWriter packet((Int)ServerPlayPacket::ChatMessage);
+	writeChatMessage(packet, message, type, isJson);
 
-	VarInt length = VarInt(packid.getSize() + smessage.getSize() + 1);
-	data.reserve(length.toInt() + length.getSize());
+	// Send the packet
+	sendPacket(client, packet);
+}
 
-	// Append the data to the string
-	data.append((char*)length.getData(), length.getSize());
-	data.append((char*)packid.getData(), packid.getSize());
-	data.append(smessage.makeData(), smessage.getSize());
-	data.append(1, (char)type);
+/*******************************************
+ * NetworkHandler :: broadcastChatMessage  *
+ * Send a message to every one of clients  *
+ *******************************************/
+void NetworkHandler::broadcastChatMessage(const std::vector<Client*>& clients, String message, ChatMessageType type, Boolean isJson)
+{
+	// Serialize the data
+	PacketWriter packet((Int)ServerPlayPacket::ChatMessage);
+	writeChatMessage(packet, message, type, isJson);
 
-	// Send the packet
-	send(client->getSocket(), data.c_str(), data.size(), NULL);
+	// Send the packet to everyone
+	broadcastPacket(clients, packet);
 }
 
 /************************************
@@ -1017,25 +1360,11 @@ void NetworkHandler::sendChatMessage(Client* client, String message, ChatMessage
 void NetworkHandler::sendJoinGame(Client* client, Int entityID, Gamemode gamemode, Dimension dimension, Difficulty difficulty, Byte maxPlayers, LevelType levelType, Boolean reducedDebugInfo)
 {
 	// Serialize the data
-	String data;
-	VarInt packid = VarInt((Int)ServerPlayPacket::JoinGame);
-	SerialString slevelType = SerialString(levelType.str());
-	VarInt length = VarInt(12 + slevelType.getSize() + packid.getSize());
-	data.reserve(length.toInt() + length.getSize());
-
-	// Append the data to the string
-	data.append((char*)length.getData(), length.getSize());
-	data.append((char*)packid.getData(), packid.getSize());
-	writeInt(data, entityID);
-	data.append(1, (char)gamemode);
-	writeInt(data, (Int)dimension);
-	data.append(1, (char)difficulty);
-	data.append(1, maxPlayers);
-	data.append(slevelType.makeData(), slevelType.getSize());
-	data.append(1, (char)reducedDebugInfo);
+	PacketWriter packet((Int)ServerPlayPacket::JoinGame);
+	JoinGameFields::write(packet, entityID, (UByte)gamemode, (Int)dimension, (UByte)difficulty, (UByte)maxPlayers, levelType.str(), reducedDebugInfo);
 
 	// Send the packet
-	send(client->getSocket(), data.c_str(), data.size(), NULL);
+	sendPacket(client, packet);
 }
 
 /***************************************
@@ -1045,40 +1374,32 @@ void NetworkHandler::sendJoinGame(Client* client, Int entityID, Gamemode gamemod
 void NetworkHandler::sendPluginMessage(Client* client, String channel, Byte* data2, Int dataLen)
 {
 	// Serialize the data
-	String data;
-	VarInt packid = VarInt((Int)ServerPlayPacket::PluginMessage);
-	SerialString schannel = SerialString(channel);
-	VarInt length = VarInt(packid.getSize() + schannel.getSize() + dataLen);
-	data.reserve(length.toInt() + length.getSize());
-
-	// Append the data to the string
-	data.append((char*)length.getData(), length.getSize());
-	data.append((char*)packid.getData(), packid.getSize());
-	data.append(schannel.makeData(), schannel.getSize());
-	data.append((char*)data2, dataLen);
+	PacketWriter packet((Int)ServerPlayPacket::PluginMessage);
+	packet.writeString(channel);
+	packet.writeBytes(data2, dataLen);
 
 	// Send the packet
-	send(client->getSocket(), data.c_str(), data.size(), NULL);
+	sendPacket(client, packet);
 }
 
 /******************************************
- * NetworkHandler :: sendChunkColumn      *
- * Sends a column of chunks to the client *
+ * NetworkHandler :: writeChunk           *
+ * Serializes a column of chunks into the *
+ * packet (on any thread)                 *
  ******************************************/
-void NetworkHandler::sendChunk(Client* client, Int x, Int z, ChunkColumn& column, Boolean createChunk, Boolean inOverworld)
+void NetworkHandler::writeChunk(PacketWriter& packet, Int x, Int z, ChunkColumn& column, Boolean createChunk, Boolean inOverworld)
 {
 	// Figure out which chunks are not empty and serialize their data
+	// (into a buffer the thread keeps around, since its size has to go in front of it)
 	int bitmask = 0;
-	int counter = 0;
-	String chunkdata = "";
-	chunkdata.reserve(0x20000);
+	static thread_local String chunkdata;
+	chunkdata.clear();
 	for (int ch = 0; ch < 16; ++ch)
 	{
 		// If the chunk is filled then serialize its data using the global palette
 		if (!column.chunks[ch].empty())
 		{
 			bitmask |= 1 << ch;
-			counter++;
 
 			/* TODO: Create and send a palette
 			VarInt paletteLength = VarInt(0);
@@ -1093,28 +1414,18 @@ void NetworkHandler::sendChunk(Client* client, Int x, Int z, ChunkColumn& column
 				bs.push_back(column.chunks[ch].getBlockData(i), MAX_BITS_PER_BLOCK); */
 
 			// Create and send a 1-block palette
-			VarInt paletteLength = VarInt(16);
-			VarInt palette[16];
-			palette[0] = VarInt((Int)BlockID::Air << 4);
-			palette[1] = VarInt((Int)BlockID::Grass << 4);
-			palette[2] = VarInt((Int)BlockID::Dirt << 4);
-			palette[3] = VarInt((Int)BlockID::Cobblestone << 4);
-			palette[4] = VarInt((Int)BlockID::Stone << 4);
-			palette[5] = VarInt((Int)BlockID::StoneBrick << 4);
-			palette[6] = VarInt((Int)BlockID::RedBricks << 4);
-			palette[7] = VarInt((Int)BlockID::NetherBrick << 4);
-			palette[8] = VarInt((Int)BlockID::Log << 4);
-			palette[9] = VarInt((Int)BlockID::Log2 << 4);
-			palette[10] = VarInt((Int)BlockID::Planks << 4);
-			palette[11] = VarInt((Int)BlockID::Sand << 4);
-			palette[12] = VarInt((Int)BlockID::RedSandstone << 4);
-			palette[13] = VarInt((Int)BlockID::Wool << 4);
-			palette[14] = VarInt((Int)BlockID::Clay << 4);
-			palette[15] = VarInt((Int)BlockID::TNT << 4);
+			static const Int palette[16] =
+			{
+				(Int)BlockID::Air << 4, (Int)BlockID::Grass << 4, (Int)BlockID::Dirt << 4, (Int)BlockID::Cobblestone << 4,
+				(Int)BlockID::Stone << 4, (Int)BlockID::StoneBrick << 4, (Int)BlockID::RedBricks << 4, (Int)BlockID::NetherBrick << 4,
+				(Int)BlockID::Log << 4, (Int)BlockID::Log2 << 4, (Int)BlockID::Planks << 4, (Int)BlockID::Sand << 4,
+				(Int)BlockID::RedSandstone << 4, (Int)BlockID::Wool << 4, (Int)BlockID::Clay << 4, (Int)BlockID::TNT << 4
+			};
+			Byte encodedPalette[VARINT_MAX_SIZE * 17];
+			size_t paletteSize = VarInt::encode(16, encodedPalette);
+			paletteSize += encodeVarInts(palette, 16, encodedPalette + paletteSize);
 			chunkdata.append(1, 4);	// Bits per entry
-			chunkdata.append((char*)paletteLength.getData(), paletteLength.getSize());
-			for (int i = 0; i < 16; ++i)
-				chunkdata.append((char*)palette[i].getData(), palette[i].getSize());
+			chunkdata.append((char*)encodedPalette, paletteSize);
 
 			// Send all of the blocks from that palette
 			VarInt chunkdataSize = VarInt(256); // 64 * bitsize
@@ -1204,29 +1515,28 @@ void NetworkHandler::sendChunk(Client* client, Int x, Int z, ChunkColumn& column
 	// TODO: serialize block entities
 
 	// Serialize the data
-	String data;
-	VarInt packid = VarInt((Int)ServerPlayPacket::ChunkData);
-	VarInt sbitmask = VarInt(bitmask);
-	VarInt columndatasize = VarInt(chunkdata.size());
-	VarInt numBlockEntities = VarInt(0);
-	VarInt length = VarInt(packid.getSize() + sbitmask.getSize() + columndatasize.getSize() + numBlockEntities.getSize() + chunkdata.size() + 9);
-	data.reserve(length.toInt() + length.getSize());
-	
-	// Append the data to a string
-	data.append((char*)length.getData(), length.getSize());
-	data.append((char*)packid.getData(), packid.getSize());
-	writeInt(data, x);
-	writeInt(data, z);
-	data.append(1, (char)createChunk);
-	data.append((char*)sbitmask.getData(), sbitmask.getSize());
-	data.append((char*)columndatasize.getData(), columndatasize.getSize());
-	data.append(chunkdata);
-	data.append((char*)numBlockEntities.getData(), numBlockEntities.getSize());
-
-	std::cout << length.toInt() << ", " << data.size() << ", " << counter << "\n";
+	packet.writeInt(x);
+	packet.writeInt(z);
+	packet.writeBoolean(createChunk);
+	packet.writeVarInt(bitmask);
+	packet.writeVarInt((Int)chunkdata.size());
+	packet.writeBytes(chunkdata.data(), chunkdata.size());
+	packet.writeVarInt(0); // No block entities
+
+}
+
+/******************************************
+ * NetworkHandler :: sendChunkColumn      *
+ * Sends a column of chunks to the client *
+ ******************************************/
+void NetworkHandler::sendChunk(Client* client, Int x, Int z, ChunkColumn& column, Boolean createChunk, Boolean inOverworld)
+{
+	// Serialize the data
+	PacketWriter packet((Int)ServerPlayPacket::ChunkData);
+	writeChunk(packet, x, z, column, createChunk, inOverworld);
 
 	// Send the data
-	send(client->getSocket(), data.c_str(), data.size(), NULL);
+	sendPacket(client, packet);
 
 	// Register the loaded chunk into the client's data
 	client->loadedChunks.insert(std::pair<Int, Int>(x, z));
@@ -1238,16 +1548,114 @@ void NetworkHandler::sendChunk(Client* client, Int x, Int z, ChunkColumn& column
  ******************************************/
 void NetworkHandler::sendChunk(Client* client, Int x, Int z, Boolean createChunk, Boolean inOverworld)
 {
-	// Grab the chunk on the server's clock thread
-	EventHandler* handler = eventHandler;
-	NetworkHandler* nethandler = this;
+	// Hold the chunk back if the client is still busy receiving the last ones
+	if (client->outbound.size() >= OUTBOUND_HIGH_WATER)
+	{
+		DeferredChunk chunk = { x, z, createChunk, inOverworld };
+		client->deferredChunks.push_back(chunk);
+		return;
+	}
 
 	// Get the chunk column before sending it
 	GetChunkEventArgs e;
 	e.client = client;
 	e.x = x;
 	e.z = z;
-	handler->getChunk(e);
+	loadChunk(e, createChunk);
+
+	// Send the chunk column
+	sendChunk(client, x, z, e.chunk, createChunk, inOverworld);
+}
+
+/*************************************************
+ * NetworkHandler :: sendChunks                  *
+ * Sends a batch of chunk columns to the client, *
+ * loading and serializing them across the       *
+ * event handler's thread pool                   *
+ *************************************************/
+void NetworkHandler::sendChunks(Client* client, const std::vector< std::pair<Int, Int> >& chunks, Boolean createChunk, Boolean inOverworld)
+{
+	// Hold the chunks back if the client is still busy receiving the last ones
+	if (client->outbound.size() >= OUTBOUND_HIGH_WATER)
+	{
+		for (size_t i = 0; i < chunks.size(); ++i)
+		{
+			DeferredChunk chunk = { chunks[i].first, chunks[i].second, createChunk, inOverworld };
+			client->deferredChunks.push_back(chunk);
+		}
+		return;
+	}
+
+	sendEncodedChunks(client, chunks, encodeChunks(client, chunks, createChunk, inOverworld));
+}
+
+/*************************************************
+ * NetworkHandler :: encodeChunks                *
+ * Loads, serializes and (if they need it)       *
+ * deflates chunk columns for the client across  *
+ * the thread pool. Runs on any thread, with     *
+ * the packets ready to queue up afterwards      *
+ *************************************************/
+std::vector< std::shared_ptr<const String> > NetworkHandler::encodeChunks(Client* client, const std::vector< std::pair<Int, Int> >& chunks, Boolean createChunk, Boolean inOverworld)
+{
+	// Every column is loaded, serialized and (if it needs to be) deflated on its own
+	std::vector< std::shared_ptr<const String> > packets(chunks.size());
+	Int threshold = client->getCompressionThreshold();
+	Int level = compressionLevel;
+	eventHandler->getPool().parallelFor(0, chunks.size(), [&](size_t i)
+	{
+		GetChunkEventArgs e;
+		e.client = client;
+		e.x = chunks[i].first;
+		e.z = chunks[i].second;
+		loadChunk(e, createChunk);
+
+		PacketWriter packet((Int)ServerPlayPacket::ChunkData);
+		writeChunk(packet, e.x, e.z, e.chunk, createChunk, inOverworld);
+		packets[i] = encodePacket(packet, threshold, level);
+	});
+	return packets;
+}
+
+/*************************************************
+ * NetworkHandler :: sendEncodedChunks           *
+ * Queues up chunk columns that encodeChunks     *
+ * made for the client, in the order they were   *
+ * asked for                                     *
+ *************************************************/
+void NetworkHandler::sendEncodedChunks(Client* client, const std::vector< std::pair<Int, Int> >& chunks, const std::vector< std::shared_ptr<const String> >& packets)
+{
+	for (size_t i = 0; i < chunks.size(); ++i)
+	{
+		if (client->outbound.size() < OUTBOUND_HARD_LIMIT)
+			client->outbound.push(packets[i]);
+		client->loadedChunks.insert(chunks[i]);
+	}
+	flushClient(client);
+}
+
+/*************************************************
+ * NetworkHandler :: queueChunks                 *
+ * Lines up chunk columns to be streamed to the  *
+ * client over the next ticks                    *
+ *************************************************/
+void NetworkHandler::queueChunks(Client* client, const std::vector< std::pair<Int, Int> >& chunks, Boolean createChunk, Boolean inOverworld)
+{
+	for (size_t i = 0; i < chunks.size(); ++i)
+	{
+		DeferredChunk chunk = { chunks[i].first, chunks[i].second, createChunk, inOverworld };
+		client->deferredChunks.push_back(chunk);
+	}
+}
+
+/*************************************************
+ * NetworkHandler :: loadChunk                   *
+ * Asks the event handler for a chunk column and *
+ * its biomes if it's being created              *
+ *************************************************/
+void NetworkHandler::loadChunk(GetChunkEventArgs& e, Boolean createChunk)
+{
+	eventHandler->getDispatch().getChunk(eventHandler, e);
 
 	// If we're creating a chunk then grab its biome data
 	if (createChunk)
@@ -1258,15 +1666,12 @@ void NetworkHandler::sendChunk(Client* client, Int x, Int z, Boolean createChunk
 
 		// Get the biome data
 		GetBiomeEventArgs e2;
-		e2.client = client;
-		e2.x = x;
-		e2.z = z;
+		e2.client = e.client;
+		e2.x = e.x;
+		e2.z = e.z;
 		e2.biomes = &e.chunk.getBiome(0);
-		handler->getBiomes(e2);
+		eventHandler->getDispatch().getBiomes(eventHandler, e2);
 	}
-
-	// Send the chunk column
-	nethandler->sendChunk(client, x, z, e.chunk, createChunk, inOverworld);
 }
 
 
@@ -1277,18 +1682,11 @@ void NetworkHandler::sendChunk(Client* client, Int x, Int z, Boolean createChunk
 void NetworkHandler::sendServerDifficulty(Client* client, Difficulty difficulty)
 {
 	// Serialize the data
-	String data;
-	VarInt packid = VarInt((Int)ServerPlayPacket::Difficulty);
-	VarInt length = VarInt(packid.getSize() + 1);
-	data.reserve(length.toInt() + length.getSize());
-
-	// Append the data to the string
-	data.append((char*)length.getData(), length.getSize());
-	data.append((char*)packid.getData(), packid.getSize());
-	data.append(1, (char)difficulty);
+	PacketWriter packet((Int)ServerPlayPacket::Difficulty);
+	ServerDifficultyFields::write(packet, (UByte)difficulty);
 
 	// Send the packet
-	send(client->getSocket(), data.c_str(), data.size(), NULL);
+	sendPacket(client, packet);
 }
 
 /*********************************************
@@ -1298,19 +1696,11 @@ void NetworkHandler::sendServerDifficulty(Client* client, Difficulty difficulty)
 void NetworkHandler::sendSpawnPosition(Client* client, Position pos)
 {
 	// Serialize the data
-	String data;
-	VarInt packid = VarInt((Int)ServerPlayPacket::SpawnPosition);
-	SerialPosition spos = SerialPosition(pos);
-	VarInt length = VarInt(packid.getSize() + 8);
-	data.reserve(length.toInt() + length.getSize());
-
-	// Append the data to the string
-	data.append((char*)length.getData(), length.getSize());
-	data.append((char*)packid.getData(), packid.getSize());
-	writeLong(data, spos.getData());
+	PacketWriter packet((Int)ServerPlayPacket::SpawnPosition);
+	SpawnPositionFields::write(packet, pos);
 
 	// Send the packet
-	send(client->getSocket(), data.c_str(), data.size(), NULL);
+	sendPacket(client, packet);
 }
 
 /********************************************
@@ -1320,20 +1710,11 @@ void NetworkHandler::sendSpawnPosition(Client* client, Position pos)
 void NetworkHandler::sendPlayerAbilities(Client* client, PlayerAbilities abilities, Float flyingSpeed, Float fovModifier)
 {
 	// Serialize the data
-	String data;
-	VarInt packid = VarInt((Int)ServerPlayPacket::PlayerAbilities);
-	VarInt length = VarInt(packid.getSize() + 9);
-	data.reserve(length.toInt() + length.getSize());
-
-	// Append the data to the string
-	data.append((char*)length.getData(), length.getSize());
-	data.append((char*)packid.getData(), packid.getSize());
-	data.append(1, abilities.getFlags());
-	writeFloat(data, flyingSpeed);
-	writeFloat(data, fovModifier);
+	PacketWriter packet((Int)ServerPlayPacket::PlayerAbilities);
+	PlayerAbilitiesFields::write(packet, abilities.getFlags(), flyingSpeed, fovModifier);
 
 	// Send the packet
-	send(client->getSocket(), data.c_str(), data.size(), NULL);
+	sendPacket(client, packet);
 }
 
 /********************************************
@@ -1343,25 +1724,11 @@ void NetworkHandler::sendPlayerAbilities(Client* client, PlayerAbilities abiliti
 void NetworkHandler::sendPlayerPositionAndLook(Client* client, PositionF pos, Float yaw, Float pitch, PlayerPositionAndLookFlags flags, Int teleportID)
 {
 	// Serialize the data
-	String data;
-	VarInt packid = VarInt((Int)ServerPlayPacket::PlayerPositionAndLook);
-	VarInt steleportID = VarInt(teleportID);
-	VarInt length = VarInt(packid.getSize() + steleportID.getSize() + 33);
-	data.reserve(length.toInt() + length.getSize());
-
-	// Append the data to the string
-	data.append((char*)length.getData(), length.getSize());
-	data.append((char*)packid.getData(), packid.getSize());
-	writeDouble(data, pos.x);
-	writeDouble(data, pos.y);
-	writeDouble(data, pos.z);
-	writeFloat(data, yaw);
-	writeFloat(data, pitch);
-	data.append(1, flags.getFlags());
-	data.append((char*)steleportID.getData(), steleportID.getSize());
+	PacketWriter packet((Int)ServerPlayPacket::PlayerPositionAndLook);
+	PlayerPositionAndLookFields::write(packet, pos, yaw, pitch, flags.getFlags(), teleportID);
 
 	// Send the packet
-	send(client->getSocket(), data.c_str(), data.size(), NULL);
+	sendPacket(client, packet);
 }
 
 /*********************************************
@@ -1371,19 +1738,11 @@ void NetworkHandler::sendPlayerPositionAndLook(Client* client, PositionF pos, Fl
 void NetworkHandler::sendUnloadChunk(Client* client, Int x, Int z)
 {
 	// Serialize the data
-	String data;
-	VarInt packid = VarInt((Int)ServerPlayPacket::UnloadChunk);
-	VarInt length = VarInt(packid.getSize() + 8);
-	data.reserve(length.toInt() + length.getSize());
-
-	// Append the data to the string
-	data.append((char*)length.getData(), length.getSize());
-	data.append((char*)packid.getData(), packid.getSize());
-	writeInt(data, x);
-	writeInt(data, z);
+	PacketWriter packet((Int)ServerPlayPacket::UnloadChunk);
+	UnloadChunkFields::write(packet, x, z);
 
 	// Send the packet
-	send(client->getSocket(), data.c_str(), data.size(), NULL);
+	sendPacket(client, packet);
 
 	// Unregister the chunk from the client's data
 	client->loadedChunks.erase(std::pair<Int, Int>(x, z));
@@ -1396,26 +1755,94 @@ void NetworkHandler::sendUnloadChunk(Client* client, Int x, Int z)
 void NetworkHandler::sendKeepAlive(Client* client, Long id)
 {
 	// Serialize the data
-	String data;
-	VarInt packid = VarInt((Int)ServerPlayPacket::KeepAlive);
-	VarInt length = VarInt(packid.getSize() + 8);
-	data.reserve(length.toInt() + length.getSize());
-
-	// Append the data to the string
-	data.append((char*)length.getData(), length.getSize());
-	data.append((char*)packid.getData(), packid.getSize());
-	writeLong(data, id);
+	PacketWriter packet((Int)ServerPlayPacket::KeepAlive);
+	KeepAliveFields::write(packet, id);
 
 	// Send the packet
-	send(client->getSocket(), data.c_str(), data.size(), NULL);
+	sendPacket(client, packet);
+}
+
+/********************************************
+ * NetworkThread :: NetworkThread           *
+ * Default Constructor                      *
+ ********************************************/
+NetworkThread::NetworkThread(Int id) : id(id), listenSocket(INVALID_SOCKET)
+{
+#ifdef NETWORK_USE_EPOLL
+	epollFD = -1;
+#endif
+#ifdef NETWORK_USE_IO_URING
+	uring = NULL;
+#endif
 }
 
 /********************************************
  * NetworkHandler :: NetworkHandler         *
  * Default Constructor                      *
  ********************************************/
-NetworkHandler::NetworkHandler(EventHandler* eventHandler)
-	: running(false), eventHandler(eventHandler) {}
+NetworkHandler::NetworkHandler(EventHandler* eventHandler, NetworkBackend backend, Int numThreads)
+	: running(false), eventHandler(eventHandler), backend(backend), nextThread(0),
+	  compressionThreshold(DEFAULT_COMPRESSION_THRESHOLD), compressionLevel(DEFAULT_COMPRESSION_LEVEL), compressionPool(new CompressionPool())
+{
+	// Leave a core for the server thread unless we were told otherwise
+	if (numThreads <= 0)
+		numThreads = std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 1;
+	for (Int i = 0; i < numThreads; ++i)
+		threads.push_back(new NetworkThread(i));
+
+#ifdef NETWORK_USE_IO_URING
+	// Set up a ring for every thread if it was asked for, falling back to epoll if they can't be
+	if (backend == NetworkBackend::IoUring)
+	{
+		for (size_t i = 0; i < threads.size() && this->backend == NetworkBackend::IoUring; ++i)
+			if ((threads[i]->uring = createUring()) == NULL)
+				this->backend = NetworkBackend::Default;
+
+		if (this->backend != NetworkBackend::IoUring)
+			for (size_t i = 0; i < threads.size(); ++i)
+				if (threads[i]->uring != NULL)
+				{
+					destroyUring(threads[i]->uring);
+					threads[i]->uring = NULL;
+				}
+	}
+#else
+	if (backend == NetworkBackend::IoUring)
+	{
+		std::cout << "The io_uring backend was not built, using the default backend instead.\n";
+		this->backend = NetworkBackend::Default;
+	}
+#endif
+
+#ifdef NETWORK_USE_EPOLL
+	// Epoll is the best we have by default
+	if (this->backend == NetworkBackend::Default)
+		this->backend = NetworkBackend::Epoll;
+
+	// Create the epoll instance that each thread's sockets get registered with
+	if (this->backend == NetworkBackend::Epoll)
+	{
+		for (size_t i = 0; i < threads.size() && this->backend == NetworkBackend::Epoll; ++i)
+			if ((threads[i]->epollFD = epoll_create1(EPOLL_CLOEXEC)) == -1)
+			{
+				std::cout << "Error creating epoll instance: " << errno << "\n";
+				this->backend = NetworkBackend::Select;
+			}
+
+		if (this->backend != NetworkBackend::Epoll)
+			for (size_t i = 0; i < threads.size(); ++i)
+				if (threads[i]->epollFD != -1)
+				{
+					close(threads[i]->epollFD);
+					threads[i]->epollFD = -1;
+				}
+	}
+#else
+	// Everything else gets select
+	if (this->backend != NetworkBackend::Select)
+		this->backend = NetworkBackend::Select;
+#endif
+}
 
 /********************************************
  * NetworkHandler :: NetworkHandler         *
@@ -1423,35 +1850,244 @@ NetworkHandler::NetworkHandler(EventHandler* eventHandler)
  ********************************************/
 NetworkHandler::~NetworkHandler() 
 {
-	// Stop the event handler
+	// Stop the event loops and wait for them to finish
 	stop();
+	for (size_t i = 0; i < workers.size(); ++i)
+		if (workers[i].joinable())
+			workers[i].join();
+
+	// Finish off whatever is being compressed
+	delete compressionPool;
+
+	for (size_t i = 0; i < threads.size(); ++i)
+	{
+		// Close the thread's listener
+		if (threads[i]->listenSocket != INVALID_SOCKET)
+			closesocket(threads[i]->listenSocket);
+
+#ifdef NETWORK_USE_EPOLL
+		// Destroy the epoll instance
+		if (threads[i]->epollFD != -1)
+			close(threads[i]->epollFD);
+#endif
+
+#ifdef NETWORK_USE_IO_URING
+		// Destroy the ring
+		if (threads[i]->uring != NULL)
+			destroyUring(threads[i]->uring);
+#endif
+
+		delete threads[i];
+	}
+}
+
+/***********************************************************
+ * NetworkHandler :: listenForClients                      *
+ * Gives every network thread its own listener on the port *
+ * so that each one accepts its own clients. Returns false *
+ * if the platform can't share a port between sockets, in  *
+ * which case the server has to accept clients itself      *
+ ***********************************************************/
+Boolean NetworkHandler::listenForClients(Int port)
+{
+#ifdef NETWORK_USE_REUSEPORT
+	for (size_t i = 0; i < threads.size(); ++i)
+	{
+		// Create a listener that shares the port with every other thread's
+		SOCKET listener = socket(AF_INET, SOCK_STREAM, 0);
+		int on = 1;
+		sockaddr_in server = sockaddr_in();
+		server.sin_family = AF_INET;
+		server.sin_addr.s_addr = INADDR_ANY;
+		server.sin_port = htons(port);
+		if (listener == INVALID_SOCKET
+			|| setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) == SOCKET_ERROR
+			|| setsockopt(listener, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) == SOCKET_ERROR
+			|| ::bind(listener, (sockaddr*)&server, sizeof(server)) == SOCKET_ERROR
+			|| ::listen(listener, SOMAXCONN) == SOCKET_ERROR)
+		{
+			std::cout << "Failed to create listener for network thread " << threads[i]->id << ": " << WSAGetLastError() << "\n";
+			if (listener != INVALID_SOCKET)
+				closesocket(listener);
+
+			// Leave all of the accepting to the server instead
+			for (size_t j = 0; j < i; ++j)
+			{
+				closesocket(threads[j]->listenSocket);
+				threads[j]->listenSocket = INVALID_SOCKET;
+			}
+			return false;
+		}
+
+		// The thread takes every waiting client at once, so it can't wait on accept
+		fcntl(listener, F_SETFL, fcntl(listener, F_GETFL, 0) | O_NONBLOCK);
+		threads[i]->listenSocket = listener;
+
+#ifdef NETWORK_USE_EPOLL
+		// Listeners are registered without a client so they can be told apart
+		if (backend == NetworkBackend::Epoll)
+		{
+			epoll_event event;
+			event.events = EPOLLIN | EPOLLET;
+			event.data.ptr = NULL;
+			epoll_ctl(threads[i]->epollFD, EPOLL_CTL_ADD, listener, &event);
+		}
+#endif
+	}
+
+	std::cout << "Now listening to port " << port << " on " << threads.size() << " network threads...\n";
+	return true;
+#else
+	return false;
+#endif
+}
+
+/*********************************************
+ * NetworkHandler :: acceptClients           *
+ * Accepts every client that is waiting on   *
+ * the thread's listener                     *
+ *********************************************/
+void NetworkHandler::acceptClients(NetworkThread& thread)
+{
+	while (true)
+	{
+		SOCKET newClient = accept(thread.listenSocket, NULL, NULL);
+		if (newClient != INVALID_SOCKET)
+		{
+			addClient(newClient, thread);
+			continue;
+		}
+
+		// Stop once there's nobody left waiting
+		if (socketWouldBlock())
+			return;
+#ifndef _WIN32
+		if (errno == EINTR || errno == ECONNABORTED)
+			continue;
+#endif
+		std::cout << "Error accepting client: " << WSAGetLastError() << "\n";
+		return;
+	}
+}
+
+/*******************************************
+ * NetworkHandler :: addClient             *
+ * Hands a client the server accepted to   *
+ * the network threads in turn             *
+ *******************************************/
+void NetworkHandler::addClient(SOCKET& newClient)
+{
+	addClient(newClient, *threads[nextThread++ % threads.size()]);
 }
 
 /*************************************
  * NetworkHandler :: addClient       *
  * Handshakes with and adds a client *
  *************************************/
-void NetworkHandler::addClient(SOCKET& newClient)
+void NetworkHandler::addClient(SOCKET newClient, NetworkThread& thread)
 {
+	std::cout << "Found client: " << newClient << ".\n";
+
 	// Add the client to the list of clients
-	eventHandler->clients.insert(new Client(newClient));
+	Client* client = new Client(newClient);
+	client->networkThread = &thread;
+	eventHandler->clients.insert(client);
+	thread.clients.insert(client);
+
+	// Never let a client with a full window stall whichever thread is writing to it
+#ifdef _WIN32
+	u_long nonBlocking = 1;
+	ioctlsocket(newClient, FIONBIO, &nonBlocking);
+#else
+	fcntl(newClient, F_SETFL, fcntl(newClient, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+#ifdef NETWORK_USE_EPOLL
+	// Register the client with epoll, keeping the client itself as the event's data
+	// so that a ready socket never needs to be looked up again
+	if (backend == NetworkBackend::Epoll)
+	{
+		epoll_event event;
+		event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+		event.data.ptr = client;
+		if (epoll_ctl(thread.epollFD, EPOLL_CTL_ADD, newClient, &event) == -1)
+		{
+			std::cout << "Error registering " << client->getName() << " with epoll: " << errno << "\n";
+			closeClient(client);
+		}
+	}
+#endif
+
+#ifdef NETWORK_USE_IO_URING
+	// Have the ring start receiving from the client on its next iteration
+	if (backend == NetworkBackend::IoUring)
+	{
+		std::lock_guard<std::mutex> lock(thread.uring->lock);
+		thread.uring->newClients.push_back(client);
+		thread.uring->wake();
+	}
+#endif
+}
+
+/*************************************************
+ * NetworkHandler :: disconnectClient            *
+ * Has the client's network thread disconnect it *
+ * (from any thread)                             *
+ *************************************************/
+void NetworkHandler::disconnectClient(Client* client)
+{
+	// Only the thread that owns the socket ever closes it, since it may be in the middle of a batch
+	// of events for it. Shutting it down hands the thread a hang up, which it handles like any other
+	if (client->outbound.close())
+		shutdown(client->getSocket(), SD_BOTH);
 }
 
 /**************************************
- * NetworkHandler :: disconnectClient *
+ * NetworkHandler :: closeClient      *
  * Disconnects and deletes a client   *
+ * from its own network thread        *
  **************************************/
-void NetworkHandler::disconnectClient(Client* client)
+void NetworkHandler::closeClient(Client* client)
 {
-	// Disconnect the client's socket
+	// Only disconnect the client once, no matter how many threads notice it's gone
+	if (eventHandler->clients.erase(client) == 0)
+		return;
+	NetworkThread& thread = *client->networkThread;
+	thread.clients.erase(client);
+
+#ifdef NETWORK_USE_EPOLL
+	// Stop listening to the client before its socket goes away
+	if (backend == NetworkBackend::Epoll)
+		epoll_ctl(thread.epollFD, EPOLL_CTL_DEL, client->getSocket(), NULL);
+#endif
+
+	// Disconnect the client's socket. Closing the outbound queue first waits out any thread that's
+	// writing to it (like a compression worker flushing) and keeps everyone from writing to it again,
+	// so nothing is sent to whoever gets the socket's descriptor next
 	shutdown(client->getSocket(), SD_BOTH);
-	closesocket(client->getSocket());
-	eventHandler->clients.erase(client);
+	client->outbound.close();
+	Boolean lingering = false;
+#ifdef NETWORK_USE_IO_URING
+	// The ring may still be sending what it already took out of the queue, so the descriptor
+	// stays open (and can't be handed to a new client) until that send completes
+	if (backend == NetworkBackend::IoUring && thread.uring->sending.count(client))
+	{
+		thread.uring->lingering.insert(client);
+		lingering = true;
+	}
+#endif
+	if (!lingering)
+		closesocket(client->getSocket());
+
+	// Clients that only asked for the server's status never got as far as the server thread
+	if (inStatus(client))
+		return;
 
 	// Trigger the client disconnected event so that the event handler can clean up the client's data.
+	// It goes through the thread's queue so that it runs after everything the client sent before leaving.
 	ClientDisconnectEventArgs e;
 	e.client = client;
-	eventHandler->clientDisconnect(e);
+	EventQueue::Writer(thread.events)->push<EventID::clientDisconnect>(e);
 }
 
 /****************************************************
@@ -1465,72 +2101,593 @@ Client* NetworkHandler::getClientFromSocket(SOCKET& socket)
 	return *eventHandler->clients.find(&temp);
 }
 
-/***********************************
- * NetworkHandler :: start         *
- * Starts up the client event loop *
- ***********************************/
+/*********************************************************
+ * NetworkHandler :: receiveData                         *
+ * Reads some data from the client along with every      *
+ * packet in it. Returns true if data was read and       *
+ * there may be more waiting on the socket, false if     *
+ * there is nothing left or the client was disconnected  *
+ *********************************************************/
 #define BUFFER_SIZE 65536
-void NetworkHandler::start()
+Boolean NetworkHandler::receiveData(Client* client, Int flags)
 {
-	running = true;
+	// Read some data from the client
+	static thread_local char buf[BUFFER_SIZE];
+	int dataRead = recv(client->getSocket(), buf, BUFFER_SIZE, flags);
+	if (dataRead > 0)
+	{
+		// Read the packets right here, the server thread only gets the events they make
+		receivePackets(client, (Byte*)buf, dataRead);
+		return true;
+	}
 
+	// The client is not sending bytes... it disconnected.
+	if (dataRead == 0)
+		closeClient(client);
+	else
+	{
+		// A non-blocking read that found nothing isn't an error
+		if (socketWouldBlock())
+			return false;
+#ifndef _WIN32
+		if (errno == EINTR)
+			return true;
+#endif
+		std::cout << "Error reading data from " << client->getName()
+			<< ": " << WSAGetLastError() << "\n";
+		closeClient(client);
+	}
+
+	return false;
+}
+
+/***********************************************
+ * NetworkHandler :: runSelect                 *
+ * Polls every one of the thread's sockets     *
+ * with select                                 *
+ ***********************************************/
+void NetworkHandler::runSelect(NetworkThread& thread)
+{
 	while (running)
 	{
 		// Create a list of every client to listen to
-		// TODO: Make eventHandler->clients thread-safe
-		fd_set clientList;
-		if (eventHandler->clients.size() > 0)
+		if (thread.clients.size() > 0 || thread.listenSocket != INVALID_SOCKET)
 		{
-			int i = 0;
-			for (AtomicSet<Client*, ClientComparator>::iterator it = eventHandler->clients.begin(); it != eventHandler->clients.end(); it++, i++)
-				clientList.fd_array[i] = (*it)->getSocket();
-			clientList.fd_count = i;
+			fd_set clientList;
+			FD_ZERO(&clientList);
+			SOCKET maxSocket = 0;
+			if (thread.listenSocket != INVALID_SOCKET)
+			{
+				FD_SET(thread.listenSocket, &clientList);
+				maxSocket = thread.listenSocket;
+			}
+			for (AtomicSet<Client*, ClientComparator>::iterator it = thread.clients.begin(); it != thread.clients.end(); it++)
+			{
+				FD_SET((*it)->getSocket(), &clientList);
+				if ((*it)->getSocket() > maxSocket)
+					maxSocket = (*it)->getSocket();
+			}
 			timeval timeout;
+			timeout.tv_sec = 0;
 			timeout.tv_usec = 100000;
 			int returnVal;
 
 			// Listen to every client on the list
-			if ((returnVal = select(NULL, &clientList, NULL, NULL, &timeout)) > 0)
+			if ((returnVal = select((int)maxSocket + 1, &clientList, NULL, NULL, &timeout)) > 0)
 			{
-				// Receive some data from the clients
-				for (int i = 0; i < returnVal; i++)
+				// Take in any new clients
+				if (thread.listenSocket != INVALID_SOCKET && FD_ISSET(thread.listenSocket, &clientList))
 				{
-					// Find the client in our list
-					Client* client = getClientFromSocket(clientList.fd_array[i]);
+					acceptClients(thread);
+					returnVal--;
+				}
 
-					// Read some data from the client
-					char* buf = new char[BUFFER_SIZE];
-					int dataRead = recv(clientList.fd_array[i], buf, BUFFER_SIZE, NULL);
-					if (dataRead == SOCKET_ERROR)
+				// Receive some data from every client that sent something
+				for (AtomicSet<Client*, ClientComparator>::iterator it = thread.clients.begin(); it != thread.clients.end() && returnVal > 0;)
+				{
+					// Move on before reading in case the client disconnects
+					Client* client = *it++;
+					if (FD_ISSET(client->getSocket(), &clientList))
 					{
-						std::cout << "Error reading data from " << client->getName()
-							<< ": " << WSAGetLastError() << "\n";
-						disconnectClient(client);
-						delete[] buf; // Make sure no memory is leaked
+						receiveData(client);
+						returnVal--;
 					}
-					else if (dataRead > 0)
+				}
+			}
+			else if (returnVal == SOCKET_ERROR)
+			{
+				std::cout << "Error receiving client message: " << WSAGetLastError() << "\n";
+			}
+		}
+		else
+			std::this_thread::sleep_for(std::chrono::milliseconds(100)); // TODO: Replace with conditional wakeup from Server->listenForClients
+	}
+}
+
+#ifdef NETWORK_USE_EPOLL
+/****************************************************
+ * NetworkHandler :: runEpoll                       *
+ * Waits on the thread's epoll instance and serves  *
+ * whichever sockets it says are ready              *
+ ****************************************************/
+#define EPOLL_MAX_EVENTS 256
+void NetworkHandler::runEpoll(NetworkThread& thread)
+{
+	epoll_event events[EPOLL_MAX_EVENTS];
+
+	while (running)
+	{
+		// Wait for any clients to send something (wake up every so often to check if we're still running)
+		int numEvents = epoll_wait(thread.epollFD, events, EPOLL_MAX_EVENTS, 100);
+		if (numEvents == -1)
+		{
+			if (errno != EINTR)
+				std::cout << "Error waiting on epoll: " << errno << "\n";
+			continue;
+		}
+
+		for (int i = 0; i < numEvents; ++i)
+		{
+			// The listener is the only socket registered without a client
+			if (events[i].data.ptr == NULL)
+			{
+				acceptClients(thread);
+				continue;
+			}
+
+			// The client was stored alongside the event, no need to search for it
+			Client* client = (Client*)events[i].data.ptr;
+
+			// The socket broke, there's nothing left to read
+			if (events[i].events & EPOLLERR)
+			{
+				closeClient(client);
+				continue;
+			}
+
+			// The socket has room again, send whatever didn't fit before
+			if (events[i].events & EPOLLOUT)
+				flushClient(client);
+
+			// The socket is edge-triggered so read everything that is waiting on it
+			// (this also catches EPOLLRDHUP and EPOLLHUP as a read of zero bytes)
+			if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP))
+				while (receiveData(client, MSG_DONTWAIT));
+		}
+	}
+}
+#endif
+
+#ifdef NETWORK_USE_IO_URING
+/****************************************************
+ * NetworkHandler :: runUring                       *
+ * Submits every receive and send in one batch and  *
+ * handles whatever completed since the last batch  *
+ ****************************************************/
+void NetworkHandler::runUring(NetworkThread& thread)
+{
+	UringState& u = *thread.uring;
+	armWake(u);
+	if (thread.listenSocket != INVALID_SOCKET)
+		armAccept(u, thread.listenSocket);
+
+	while (running)
+	{
+		// Pick up whatever the other threads left for the ring
+		std::vector<Client*> newClients;
+		std::vector<Client*> flushes;
+		{
+			std::lock_guard<std::mutex> lock(u.lock);
+			newClients.swap(u.newClients);
+			flushes.swap(u.flushes);
+			u.wakePending = false;
+		}
+
+		// Start receiving from the new clients
+		for (size_t i = 0; i < newClients.size(); ++i)
+		{
+			UringRequest* request = new UringRequest(UringOp::Receive, newClients[i]);
+			u.receives[newClients[i]] = request;
+			armReceive(u, request);
+		}
+
+		// Queue up the sends, only keeping one in flight per client so that they arrive in order
+		// (clients that already have one in flight get picked up again when it completes)
+		for (size_t i = 0; i < flushes.size(); ++i)
+		{
+			if (u.sending.count(flushes[i]))
+				continue;
+			UringRequest* request = new UringRequest(UringOp::Send, flushes[i]);
+			if (!startSend(u, request))
+				delete request;
+		}
+
+		// Submit everything at once and wait for something to finish
+		io_uring_cqe* cqe;
+		__kernel_timespec timeout;
+		timeout.tv_sec = 0;
+		timeout.tv_nsec = 100000000;
+		int ret = io_uring_submit_and_wait_timeout(&u.ring, &cqe, 1, &timeout, NULL);
+		if (ret < 0 && ret != -ETIME && ret != -EINTR)
+			std::cout << "Error waiting on io_uring: " << -ret << "\n";
+
+		// Handle everything that completed
+		unsigned head;
+		unsigned numCompleted = 0;
+		std::vector<UShort> readBuffers;
+		io_uring_for_each_cqe(&u.ring, head, cqe)
+		{
+			++numCompleted;
+			UringRequest* request = (UringRequest*)io_uring_cqe_get_data(cqe);
+			Client* client = request->client;
+			switch (request->op)
+			{
+			case UringOp::Wake:
+				// Another thread left us some work, it'll be picked up at the top of the loop
+				armWake(u);
+				break;
+			case UringOp::Accept:
+				// A client connected, it gets a receive armed at the top of the loop
+				if (cqe->res >= 0)
+					addClient(cqe->res, thread);
+				else
+					std::cout << "Error accepting client: " << -cqe->res << "\n";
+
+				// The multishot accept stopped, start it back up
+				if (!(cqe->flags & IORING_CQE_F_MORE))
+					armAccept(u, thread.listenSocket);
+				break;
+			case UringOp::Receive:
+			{
+				// Check that the receive wasn't left over from a client we already dropped
+				std::map<Client*, UringRequest*>::iterator it = u.receives.find(client);
+				Boolean active = it != u.receives.end() && it->second == request;
+
+				// Read the packets straight out of the buffer and give it right back
+				if (cqe->res > 0)
+				{
+					UShort id = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+					if (active)
+						receivePackets(client, (Byte*)u.getBuffer(id), cqe->res);
+					readBuffers.push_back(id);
+				}
+
+				// The multishot receive stopped, find out why
+				if (!(cqe->flags & IORING_CQE_F_MORE))
+				{
+					if (!active)
+						delete request;
+					else if (cqe->res == -ENOBUFS)
+						u.starved.push_back(client);
+					else if (cqe->res > 0)
+						armReceive(u, request);
+					else
 					{
-						// Attempt to read the varPack, it is up to readPacket to delete buf
-						eventHandler->runOnServerThread([client, buf, dataRead, this]() { this->readPacket(client, (Byte*)buf, dataRead, true); });
+						// The client hung up or the socket broke
+						if (cqe->res < 0)
+							std::cout << "Error reading data from " << client->getName() << ": " << -cqe->res << "\n";
+						u.receives.erase(it);
+						delete request;
+						closeClient(client);
 					}
-					// The client is not sending bytes... it disconnected.
-					else
+				}
+				break;
+			}
+			case UringOp::Send:
+				// The client is gone (or going), so whatever is left of the data goes nowhere.
+				// If it was already closed then its descriptor was kept open for this send until now
+				if (client->outbound.isClosed())
+				{
+					u.sending.erase(client);
+					if (u.lingering.erase(client))
+						closesocket(client->getSocket());
+					delete request;
+					break;
+				}
+
+				// The socket took only some of the data, send the rest
+				if (cqe->res > 0)
+				{
+					request->data.consume(cqe->res);
+					if (!request->data.empty())
 					{
-						disconnectClient(client);
-						delete[] buf; // Make sure no memory is leaked
+						armSend(u, request);
+						break;
 					}
 				}
+
+				// Send whatever piled up while this send was in flight
+				u.sending.erase(client);
+				if (cqe->res < 0 || !startSend(u, request))
+					delete request;
+				break;
 			}
-			else if (returnVal == SOCKET_ERROR)
+		}
+		io_uring_cq_advance(&u.ring, numCompleted);
+
+		// Give the buffers back to the kernel now that they've been read
+		// and restart any receives that had stopped for lack of buffers
+		if (!readBuffers.empty())
+			recycleBuffers(u, readBuffers);
+		for (size_t i = 0; i < u.starved.size(); ++i)
+			if (u.receives.count(u.starved[i]))
+				armReceive(u, u.receives[u.starved[i]]);
+		u.starved.clear();
+	}
+}
+#endif
+
+/*******************************************************
+ * NetworkHandler :: sendPacket                        *
+ * Queues a serialized packet up for the client. It    *
+ * goes out with the next flush, which is at the end   *
+ * of the tick unless the queue grows too big first    *
+ *******************************************************/
+void NetworkHandler::sendPacket(Client* client, PacketWriter& packet)
+{
+	// Don't let a client that isn't reading hold onto any more memory, it's disconnected at the end of the tick,
+	// and don't bother with clients that are already gone (the server hears about it after a short while)
+	if (client->outbound.size() >= OUTBOUND_HARD_LIMIT || client->outbound.isClosed())
+		return;
+
+	// Packets that need deflating go to the compression workers so that zlib never holds up the tick,
+	// they keep their place in the queue (and hold up everything behind them) until they're done
+	Int threshold = client->getCompressionThreshold();
+	if (threshold >= 0 && packet.getBodySize() >= threshold)
+	{
+		std::shared_ptr<OutboundPending> pending = client->outbound.pushPending(packet.getBodySize());
+		Int level = compressionLevel;
+		compressionPool->push([this, client, pending, level, body = String(packet.getBody(), packet.getBodySize())]()
+		{
+			pending->data = std::make_shared<const String>(compressPacket(body, level));
+			pending->ready.store(true, std::memory_order_release);
+
+			// Nothing is written once the client's disconnected, even if it happens while this runs
+			flushClient(client);
+		});
+		return;
+	}
+
+	// Everything else gets copied straight out of the writer's buffer
+	packet.finish(threshold >= 0);
+	client->outbound.push(packet.getData(), packet.getSize());
+	if (client->outbound.size() >= OUTBOUND_FLUSH_THRESHOLD)
+		flushClient(client);
+}
+
+/*****************************************************************
+ * NetworkHandler :: broadcastPacket                             *
+ * Queues the same packet up for every one of the clients. Each  *
+ * format the packet goes out in is encoded once and shared by   *
+ * every client's queue, and it's deflated at most once no       *
+ * matter how many of them need it compressed                    *
+ *****************************************************************/
+void NetworkHandler::broadcastPacket(const std::vector<Client*>& clients, PacketWriter& packet)
+{
+	std::shared_ptr<const String> uncompressed;   // For clients that haven't turned compression on
+	std::shared_ptr<const String> belowThreshold; // For clients with compression on, but not for a packet this small
+	std::shared_ptr<OutboundPending> deflated;    // For clients that need it compressed
+	std::vector<Client*> waiting;
+	Int bodySize = packet.getBodySize();
+
+	for (Client* client : clients)
+	{
+		// Don't let a client that isn't reading hold onto any more memory, it's disconnected at the end of the tick,
+		// and leave out clients that are already gone
+		if (client->outbound.size() >= OUTBOUND_HARD_LIMIT || client->outbound.isClosed())
+			continue;
+
+		// Hold the client's spot for the compressed packet, which is only deflated once everyone's queued
+		Int threshold = client->getCompressionThreshold();
+		if (threshold >= 0 && bodySize >= threshold)
+		{
+			if (!deflated)
+				deflated = std::make_shared<OutboundPending>();
+			client->outbound.pushPending(deflated, bodySize);
+			waiting.push_back(client);
+			continue;
+		}
+
+		// Finish the packet the first time it's needed in this format
+		std::shared_ptr<const String>& data = threshold >= 0 ? belowThreshold : uncompressed;
+		if (!data)
+		{
+			packet.finish(threshold >= 0);
+			data = std::make_shared<const String>(packet.getData(), packet.getSize());
+		}
+		client->outbound.push(data);
+		if (client->outbound.size() >= OUTBOUND_FLUSH_THRESHOLD)
+			flushClient(client);
+	}
+
+	// Deflate it on the compression workers and send it to everyone that was waiting on it
+	if (deflated)
+	{
+		Int level = compressionLevel;
+		compressionPool->push([this, deflated, level, waiting, body = String(packet.getBody(), bodySize)]()
+		{
+			deflated->data = std::make_shared<const String>(compressPacket(body, level));
+			deflated->ready.store(true, std::memory_order_release);
+
+			// Clients that disconnected in the meantime have closed queues, which aren't written
+			for (Client* client : waiting)
+				flushClient(client);
+		});
+	}
+}
+
+/*************************************************************
+ * NetworkHandler :: flushClient                             *
+ * Writes everything queued up for the client in as few      *
+ * gather writes as it takes, or hands it to the ring        *
+ *************************************************************/
+void NetworkHandler::flushClient(Client* client)
+{
+	if (client->outbound.empty())
+		return;
+
+#ifdef NETWORK_USE_IO_URING
+	// Leave the client for the ring, which submits every send in one batch
+	if (backend == NetworkBackend::IoUring && running)
+	{
+		UringState* uring = client->networkThread->uring;
+		std::lock_guard<std::mutex> lock(uring->lock);
+		uring->flushes.push_back(client);
+		uring->wake();
+		return;
+	}
+#endif
+
+	Long sent = client->outbound.flush([client](const OutboundSlice* slices, Int count) -> Long
+	{
+#ifdef _WIN32
+		WSABUF bufs[OUTBOUND_MAX_SLICES];
+		for (Int i = 0; i < count; ++i)
+		{
+			bufs[i].buf = (CHAR*)slices[i].data;
+			bufs[i].len = (ULONG)slices[i].length;
+		}
+		DWORD sent = 0;
+		if (WSASend(client->getSocket(), bufs, count, &sent, 0, NULL, NULL) == SOCKET_ERROR)
+			return -1;
+		return sent;
+#else
+		iovec iov[OUTBOUND_MAX_SLICES];
+		for (Int i = 0; i < count; ++i)
+		{
+			iov[i].iov_base = (void*)slices[i].data;
+			iov[i].iov_len = slices[i].length;
+		}
+		msghdr msg = msghdr();
+		msg.msg_iov = iov;
+		msg.msg_iovlen = count;
+		return sendmsg(client->getSocket(), &msg, MSG_NOSIGNAL);
+#endif
+	});
+
+	// Anything the socket couldn't take stays queued for the next flush
+	if (sent < 0 && !socketWouldBlock())
+		std::cout << "Error sending data to " << client->getName() << ": " << WSAGetLastError() << "\n";
+}
+
+/******************************************************
+ * NetworkHandler :: flushClients                     *
+ * Writes out every client's outbound queue and       *
+ * disconnects the clients that can't keep up         *
+ ******************************************************/
+void NetworkHandler::flushClients()
+{
+	// Go by the tick's copy of the clients, since the network threads change the set whenever they like
+	for (Client* client : eventHandler->tickClients)
+	{
+		flushClient(client);
+
+		// Give clients that fell behind some time to catch up before dropping them
+		size_t queued = client->outbound.size();
+		if (queued >= OUTBOUND_HIGH_WATER)
+		{
+			if (queued >= OUTBOUND_HARD_LIMIT || client->incrementTicksCongested(1) > OUTBOUND_MAX_CONGESTED_TICKS)
 			{
-				std::cout << "Error receiving client message: " << WSAGetLastError() << "\n";
+				std::cout << client->getName() << " can't keep up with the server, disconnecting.\n";
+				disconnectClient(client);
 			}
+			continue;
 		}
-		else
-			Sleep(100); // TODO: Replace with conditional wakeup from Server->listenForClients
+		client->resetTicksCongested();
+	}
+}
+
+/******************************************************
+ * NetworkHandler :: streamChunks                     *
+ * Sends the clients' waiting chunks a batch at a     *
+ * time, going around the clients until they're all   *
+ * sent or the deadline passes. At least one batch is *
+ * always sent, and clients that still have too much  *
+ * to receive are skipped                             *
+ ******************************************************/
+Int NetworkHandler::streamChunks(std::chrono::steady_clock::time_point deadline)
+{
+	Int sent = 0;
+	std::vector< std::pair<Int, Int> > batch;
+	for (Boolean progress = true; progress;)
+	{
+		progress = false;
+		for (Client* client : eventHandler->tickClients)
+		{
+			if (client->deferredChunks.empty() || client->outbound.size() >= OUTBOUND_HIGH_WATER)
+				continue;
+
+			// Batch up the next chunks that are sent the same way
+			DeferredChunk first = client->deferredChunks.front();
+			batch.clear();
+			while (batch.size() < CHUNK_STREAM_BATCH && !client->deferredChunks.empty()
+				&& client->deferredChunks.front().createChunk == first.createChunk
+				&& client->deferredChunks.front().inOverworld == first.inOverworld)
+			{
+				batch.push_back(std::pair<Int, Int>(client->deferredChunks.front().x, client->deferredChunks.front().z));
+				client->deferredChunks.pop_front();
+			}
+			sendChunks(client, batch, first.createChunk, first.inOverworld);
+			sent += (Int)batch.size();
+			progress = true;
+
+			if (std::chrono::steady_clock::now() >= deadline)
+				return sent;
+		}
+	}
+	return sent;
+}
+
+/**********************************************
+ * NetworkHandler :: runInbound               *
+ * Runs everything the network threads handed *
+ * to the server thread since the last tick   *
+ **********************************************/
+void NetworkHandler::runInbound()
+{
+	for (size_t i = 0; i < threads.size(); ++i)
+		threads[i]->events.run(eventHandler, eventHandler->getDispatch());
+}
+
+/*******************************************
+ * NetworkHandler :: run                   *
+ * Runs the backend's event loop on one of *
+ * the network threads                     *
+ *******************************************/
+void NetworkHandler::run(NetworkThread& thread)
+{
+	switch (backend)
+	{
+#ifdef NETWORK_USE_IO_URING
+	case NetworkBackend::IoUring:
+		runUring(thread);
+		break;
+#endif
+#ifdef NETWORK_USE_EPOLL
+	case NetworkBackend::Epoll:
+		runEpoll(thread);
+		break;
+#endif
+	default:
+		runSelect(thread);
+		break;
 	}
 }
 
+/***********************************************
+ * NetworkHandler :: start                     *
+ * Starts up every network thread, running the *
+ * first one's event loop on this thread       *
+ ***********************************************/
+void NetworkHandler::start()
+{
+	running = true;
+
+	for (size_t i = 1; i < threads.size(); ++i)
+		workers.push_back(std::thread(&NetworkHandler::run, this, std::ref(*threads[i])));
+	run(*threads[0]);
+}
+
 /*********************************************************
  * NetworkHandler :: startAsync                          *
  * Starts up the client event loop on a different thread *
@@ -2,6 +2,7 @@
 #include "server/server.h"
 #include <iostream>
 #include <thread>
+#include <chrono>
 
 
 
@@ -85,11 +86,11 @@ int Server::listenForClients()
 	}
 
 	// Bind the listener to a port
-	sockaddr_in server = *new sockaddr_in;
+	sockaddr_in server = sockaddr_in();
 	server.sin_family = AF_INET;
-	server.sin_addr.S_un.S_addr = INADDR_ANY;
+	server.sin_addr.s_addr = INADDR_ANY;
 	server.sin_port = htons(port);
-	if (::bind(listenSocket, (SOCKADDR*)&server, sizeof(server)) == SOCKET_ERROR)
+	if (::bind(listenSocket, (sockaddr*)&server, sizeof(server)) == SOCKET_ERROR)
 	{
 		std::cout << "Failed to bind listener: " << WSAGetLastError() << "\n";
 		closesocket(listenSocket);
@@ -122,15 +123,15 @@ int Server::acceptClients()
 	while (running)
 	{
 		// Prepare to use select syscall
-		listener.fd_count = 1;
-		listener.fd_array[0] = listenSocket;
+		FD_ZERO(&listener);
+		FD_SET(listenSocket, &listener);
 		timeout.tv_sec = 0;
 		timeout.tv_usec = 100000;
 		int returnVal;
 
-		if ((returnVal = select(NULL, &listener, NULL, NULL, &timeout)) > 0)
+		if ((returnVal = select((int)listenSocket + 1, &listener, NULL, NULL, &timeout)) > 0)
 		{
-			new std::thread(&Server::addClient, this);
+			addClient();
 		}
 		else if (returnVal == SOCKET_ERROR)
 		{
@@ -142,15 +143,20 @@ int Server::acceptClients()
 	return 1;
 }
 
-/******************************************
- * Server :: addClient                    *
- * Handshakes with the client and adds it *
- ******************************************/
+/*************************************************
+ * Server :: addClient                           *
+ * Accepts the client and hands it to one of the *
+ * network threads                               *
+ *************************************************/
 void Server::addClient()
 {
 	// Get a connection with the client
 	SOCKET client = accept(listenSocket, NULL, NULL);
-	std::cout << "Found client: " << client << ".\n";
+	if (client == INVALID_SOCKET)
+	{
+		std::cout << "Error accepting client: " << WSAGetLastError() << "\n";
+		return;
+	}
 
 	// Set up the Client event network
 	networkHandler->addClient(client);
@@ -162,9 +168,11 @@ void Server::addClient()
  *********************/
 void Server::start(double tps)
 {
-	// Begin listening for clients
+	// Begin listening for clients, letting every network thread accept its own if the platform allows it
 	running = true;
-	listenForClients();
+	Boolean threadsAccept = networkHandler->listenForClients(port);
+	if (!threadsAccept)
+		listenForClients();
 
 	// Start up the client handler on a different thread
 	networkHandler->startAsync();
@@ -172,8 +180,12 @@ void Server::start(double tps)
 	// Start up the server event handler's clock on a different thread
 	eventHandler->startTickClock(1.0 / tps);
 
-	// Begin accepting clients
-	acceptClients();
+	// Begin accepting clients (or just wait around if the network threads are doing it)
+	if (threadsAccept)
+		while (running)
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	else
+		acceptClients();
 }
 
 /*******************************************
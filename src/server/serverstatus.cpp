@@ -0,0 +1,150 @@
+#include "debug.h"
+#include "server/serverstatus.h"
+#include "data/packetwriter.h"
+#include "data/networkpackets.h"
+#include <algorithm>
+#include <cstdio>
+
+/****************************************************
+ * escapeJson                                       *
+ * Escapes text so that it can go in a JSON string  *
+ ****************************************************/
+String escapeJson(const String& text)
+{
+	String escaped;
+	escaped.reserve(text.size());
+	for (char c : text)
+	{
+		switch (c)
+		{
+		case '"':  escaped += "\\\""; break;
+		case '\\': escaped += "\\\\"; break;
+		case '\n': escaped += "\\n"; break;
+		case '\r': escaped += "\\r"; break;
+		case '\t': escaped += "\\t"; break;
+		default:
+			if ((unsigned char)c < 0x20)
+			{
+				char code[7];
+				snprintf(code, sizeof(code), "\\u%04x", (unsigned char)c);
+				escaped += code;
+			}
+			else
+				escaped += c;
+		}
+	}
+	return escaped;
+}
+
+/****************************************
+ * Server Status :: Server Status       *
+ * Constructor                          *
+ ****************************************/
+ServerStatus::ServerStatus(String motd, Int maxPlayers) : motd(motd), maxPlayers(maxPlayers)
+{
+	rebuild();
+}
+
+/****************************************
+ * Server Status :: Set Motd            *
+ * Changes the message of the day       *
+ ****************************************/
+void ServerStatus::setMotd(String motd)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	if (this->motd == motd)
+		return;
+	this->motd = motd;
+	rebuild();
+}
+
+/****************************************
+ * Server Status :: Set Favicon         *
+ * Changes the server's icon            *
+ ****************************************/
+void ServerStatus::setFavicon(String favicon)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	if (this->favicon == favicon)
+		return;
+	this->favicon = favicon;
+	rebuild();
+}
+
+/****************************************
+ * Server Status :: Set Max Players     *
+ * Changes how many players can join    *
+ ****************************************/
+void ServerStatus::setMaxPlayers(Int maxPlayers)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	if (this->maxPlayers == maxPlayers)
+		return;
+	this->maxPlayers = maxPlayers;
+	rebuild();
+}
+
+/****************************************
+ * Server Status :: Add Player          *
+ * A player joined the game             *
+ ****************************************/
+void ServerStatus::addPlayer(String name, String uuid)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	players.push_back(std::pair<String, String>(name, uuid));
+	rebuild();
+}
+
+/****************************************
+ * Server Status :: Remove Player       *
+ * A player left the game               *
+ ****************************************/
+void ServerStatus::removePlayer(String uuid)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	std::vector< std::pair<String, String> >::iterator it = std::find_if(players.begin(), players.end(),
+		[&uuid](const std::pair<String, String>& player) { return player.second == uuid; });
+	if (it == players.end())
+		return;
+	players.erase(it);
+	rebuild();
+}
+
+/****************************************************
+ * Server Status :: Get Response                    *
+ * Returns the finished Response packet, which can  *
+ * be queued up for any number of clients as is     *
+ ****************************************************/
+std::shared_ptr<const String> ServerStatus::getResponse()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return response;
+}
+
+/****************************************************
+ * Server Status :: Rebuild                         *
+ * Serializes the Response packet all over again    *
+ * Expects the lock to already be held              *
+ ****************************************************/
+void ServerStatus::rebuild()
+{
+	// Put together the JSON
+	String json = "{\"version\":{\"name\":\"" STATUS_VERSION_NAME "\",\"protocol\":" + std::to_string(STATUS_PROTOCOL_VERSION) + "},";
+	json += "\"players\":{\"max\":" + std::to_string(maxPlayers) + ",\"online\":" + std::to_string(players.size()) + ",\"sample\":[";
+	for (size_t i = 0; i < players.size() && i < STATUS_MAX_SAMPLE; ++i)
+	{
+		if (i > 0)
+			json += ",";
+		json += "{\"name\":\"" + escapeJson(players[i].first) + "\",\"id\":\"" + escapeJson(players[i].second) + "\"}";
+	}
+	json += "]},\"description\":{\"text\":\"" + escapeJson(motd) + "\"}";
+	if (!favicon.empty())
+		json += ",\"favicon\":\"data:image/png;base64," + favicon + "\"";
+	json += "}";
+
+	// Status packets are never compressed, so the packet can be finished right away
+	PacketWriter packet((Int)ServerStatusPacket::Response);
+	packet.writeString(json);
+	packet.finish();
+	response = std::make_shared<const String>(packet.getData(), packet.getSize());
+}
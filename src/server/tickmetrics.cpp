@@ -0,0 +1,131 @@
+#include "debug.h"
+#include "server/tickmetrics.h"
+
+/********************************
+ * Tick Metrics :: Tick Metrics *
+ * Default Constructor          *
+ ********************************/
+TickMetrics::TickMetrics() { reset(); }
+
+/****************************************
+ * Tick Metrics :: toBucket             *
+ * Finds the histogram bucket of a tick *
+ ****************************************/
+Int TickMetrics::toBucket(Double mspt)
+{
+	if (mspt < 0.0)
+		return 0;
+	if (mspt >= TICK_HISTOGRAM_BUCKETS - 1)
+		return TICK_HISTOGRAM_BUCKETS - 1;
+	return (Int)mspt;
+}
+
+/*************************************************
+ * Tick Metrics :: record                        *
+ * Adds a tick, pushing the oldest one out of    *
+ * the window once it's full                     *
+ *************************************************/
+void TickMetrics::record(Double start, Double mspt, Int ticksSkipped)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	if (count == TICK_METRICS_WINDOW)
+	{
+		buckets[toBucket(samples[next].mspt)]--;
+		totalMSPT -= samples[next].mspt;
+	}
+	else
+		count++;
+
+	samples[next].start = start;
+	samples[next].mspt = mspt;
+	next = (next + 1) % TICK_METRICS_WINDOW;
+	buckets[toBucket(mspt)]++;
+	totalMSPT += mspt;
+	if (mspt > peakMSPT)
+		peakMSPT = mspt;
+	ticks++;
+	skipped += ticksSkipped;
+}
+
+/*************************************************
+ * Tick Metrics :: getMSPT                       *
+ * Average milliseconds per tick over the window *
+ *************************************************/
+Double TickMetrics::getMSPT() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return count ? totalMSPT / count : 0.0;
+}
+
+/*************************************************
+ * Tick Metrics :: getTPS                        *
+ * Ticks per second over the window, measured    *
+ * from the start of the oldest to the newest    *
+ *************************************************/
+Double TickMetrics::getTPS() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	if (count < 2)
+		return 0.0;
+	Int oldest = count == TICK_METRICS_WINDOW ? next : 0;
+	Int newest = (next + TICK_METRICS_WINDOW - 1) % TICK_METRICS_WINDOW;
+	Double elapsed = samples[newest].start - samples[oldest].start;
+	return elapsed > 0.0 ? (count - 1) / elapsed : 0.0;
+}
+
+/*************************************************
+ * Tick Metrics :: getPercentile                 *
+ * Walks the histogram up to the given fraction  *
+ * of the window and gives that bucket's top end *
+ *************************************************/
+Double TickMetrics::getPercentile(Double fraction) const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	if (count == 0)
+		return 0.0;
+
+	// The slowest bucket has no top end, so the slowest tick stands in for it
+	Long wanted = (Long)(fraction * count + 0.999999);
+	if (wanted < 1)
+		wanted = 1;
+	Long seen = 0;
+	for (Int i = 0; i < TICK_HISTOGRAM_BUCKETS - 1; ++i)
+	{
+		seen += buckets[i];
+		if (seen >= wanted)
+			return i + 1.0;
+	}
+	return peakMSPT;
+}
+
+/**********************************************
+ * Tick Metrics :: getHistogram               *
+ * Copies out the histogram of the window     *
+ **********************************************/
+void TickMetrics::getHistogram(std::vector<Long>& histogram) const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	histogram.assign(buckets, buckets + TICK_HISTOGRAM_BUCKETS);
+}
+
+/* Getters */
+Double TickMetrics::getPeakMSPT() const { std::lock_guard<std::mutex> guard(lock); return peakMSPT; }
+Long TickMetrics::getTickCount() const { std::lock_guard<std::mutex> guard(lock); return ticks; }
+Long TickMetrics::getSkippedTicks() const { std::lock_guard<std::mutex> guard(lock); return skipped; }
+
+/**********************************************
+ * Tick Metrics :: reset                      *
+ * Forgets every tick                         *
+ **********************************************/
+void TickMetrics::reset()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	next = 0;
+	count = 0;
+	for (Int i = 0; i < TICK_HISTOGRAM_BUCKETS; ++i)
+		buckets[i] = 0;
+	totalMSPT = 0.0;
+	peakMSPT = 0.0;
+	ticks = 0;
+	skipped = 0;
+}
@@ -0,0 +1,90 @@
+#include "asynctest.h"
+#include "data/async.h"
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <thread>
+
+ThreadPool* workers;
+PriorityJobQueue serverJobs;
+std::thread::id serverThread;
+std::atomic<int> frames(0);
+
+/*******************************************************
+ * Frame                                               *
+ * Counts the coroutines that haven't been freed       *
+ *******************************************************/
+struct Frame
+{
+	Frame() { ++frames; }
+	~Frame() { --frames; }
+};
+
+/* Doubles the number on a worker and gives it back on the "server thread" */
+Async<int> doubleOnPool(int value)
+{
+	Frame frame;
+	co_await resumeOn(*workers);
+	assert(std::this_thread::get_id() != serverThread);
+	int doubled = value * 2;
+	co_await resumeOn(serverJobs);
+	assert(std::this_thread::get_id() == serverThread);
+	co_return doubled;
+}
+
+/* Finishes without ever suspending */
+Async<int> immediately(int value)
+{
+	Frame frame;
+	co_return value;
+}
+
+/* Awaits the others, the way an event handler would */
+Async<void> handler(int* result)
+{
+	Frame frame;
+	int a = co_await doubleOnPool(10);
+	int b = co_await doubleOnPool(a);
+	int c = co_await immediately(b + 1);
+	*result = c;
+}
+
+/***************************************************************
+ * ASYNC TEST                                                  *
+ ***************************************************************
+ * Tests that coroutines hop between the pool and the thread   *
+ * running the job queue, that awaiting one that's already     *
+ * done carries straight on, and that coroutines nobody holds  *
+ * onto anymore finish and free themselves                     *
+ ***************************************************************/
+void AsyncTest() {
+	ThreadPool pool(2);
+	workers = &pool;
+	serverThread = std::this_thread::get_id();
+
+	// Kept and awaited
+	std::cout << "Awaiting coroutines...\n";
+	int result = 0;
+	{
+		Async<void> task = handler(&result);
+		while (!task.done())
+			serverJobs.run(JobPriority::Bulk);
+	}
+	assert(result == 41 && frames.load() == 0);
+
+	// Dropped right away, like the event handlers' are
+	std::cout << "Detaching coroutines...\n";
+	int results[50] = { 0 };
+	for (int i = 0; i < 50; ++i)
+		handler(&results[i]);
+	for (int i = 0; i < 1000 && frames.load() > 0; ++i)
+	{
+		serverJobs.run(JobPriority::Bulk);
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	assert(frames.load() == 0);
+	for (int i = 0; i < 50; ++i)
+		assert(results[i] == 41);
+
+	std::cout << "Done!\n";
+}
@@ -49,5 +49,12 @@ void AtomicSetTest() {
 	for (int i = 0; i < 10; ++i)
 		threads[i].join();
 
-
+	// Take a copy while the set is being cleared out from under it, it should come out whole either way
+	cout << "\nTaking a snapshot...\n";
+	thread clearer([&](){ testData.clear(); });
+	std::vector<int> copy = testData.snapshot();
+	clearer.join();
+	for (size_t i = 1; i < copy.size(); ++i)
+		if (copy[i - 1] >= copy[i])
+			cout << "Snapshot out of order at " << i << "\n";
 }
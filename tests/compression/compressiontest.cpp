@@ -0,0 +1,42 @@
+#include "compressiontest.h"
+#include "data/compression.h"
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+/***************************************************************
+ * COMPRESSION TEST                                            *
+ ***************************************************************
+ * Tests that data comes back out of the thread's zlib streams *
+ * the way it went in, that the streams can be reused at any   *
+ * level, and that bad data gets caught                        *
+ ***************************************************************/
+void CompressionTest() {
+	String data;
+	for (int i = 0; i < 20000; ++i)
+		data.append(1, (char)(i % 37));
+
+	// Deflate and inflate a few times so that the streams get reused
+	std::cout << "Deflating and inflating...\n";
+	for (int level = 1; level <= 9; level += 4)
+	{
+		String compressed = "header";
+		assert(deflateData(data.data(), data.size(), compressed, level));
+		assert(compressed.size() < data.size() && compressed.compare(0, 6, "header") == 0);
+
+		std::vector<Byte> inflated(data.size());
+		assert(inflateData((Byte*)compressed.data() + 6, compressed.size() - 6, inflated.data(), inflated.size()));
+		assert(String((char*)inflated.data(), inflated.size()) == data);
+	}
+
+	// The inflated size has to be exactly what was promised
+	std::cout << "Catching bad data...\n";
+	String compressed;
+	assert(deflateData(data.data(), data.size(), compressed, 6));
+	std::vector<Byte> inflated(data.size() + 1);
+	assert(!inflateData((Byte*)compressed.data(), compressed.size(), inflated.data(), data.size() - 1));
+	assert(!inflateData((Byte*)compressed.data(), compressed.size(), inflated.data(), data.size() + 1));
+	assert(!inflateData((Byte*)data.data(), 100, inflated.data(), data.size()));
+
+	std::cout << "Done!\n";
+}
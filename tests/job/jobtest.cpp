@@ -0,0 +1,77 @@
+#include "jobtest.h"
+#include "data/job.h"
+#include "data/jobqueue.h"
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <string>
+
+int alive = 0;
+
+/*******************************************************
+ * Tracked                                             *
+ * Counts how many copies of itself are around, so     *
+ * leaked or doubly destroyed callables show up        *
+ *******************************************************/
+struct Tracked
+{
+	int* calls;
+	Tracked(int* calls) : calls(calls) { ++alive; }
+	Tracked(Tracked&& other) noexcept : calls(other.calls) { ++alive; }
+	Tracked(const Tracked& other) : calls(other.calls) { ++alive; }
+	~Tracked() { --alive; }
+	void operator()() { ++*calls; }
+};
+
+/*******************************************************
+ * Big                                                 *
+ * Too big to fit inside a job                         *
+ *******************************************************/
+struct Big : public Tracked
+{
+	char padding[JOB_INLINE_SIZE * 2] = {};
+	Big(int* calls) : Tracked(calls) {}
+};
+
+/***************************************************************
+ * JOB TEST                                                    *
+ ***************************************************************
+ * Tests that jobs run whatever they were given whether it is  *
+ * stored inline or on the heap, that moving them hands over   *
+ * the callable without copying or leaking it, and that jobs   *
+ * holding move-only captures go through the job queue         *
+ ***************************************************************/
+void JobTest() {
+	static_assert(sizeof(Job) <= 64, "Jobs should fit in a cache line");
+
+	// Small and big callables, moved around
+	std::cout << "Moving jobs...\n";
+	int calls = 0;
+	{
+		Job small = Tracked(&calls);
+		Job big = Big(&calls);
+		assert(alive == 2);
+		small();
+		big();
+		Job moved = std::move(small);
+		assert(!small && moved && alive == 2);
+		moved();
+		big = std::move(moved);
+		assert(!moved && alive == 1);
+		big();
+	}
+	assert(calls == 4 && alive == 0);
+
+	// Move-only captures
+	std::cout << "Running move-only jobs...\n";
+	JobQueue queue;
+	std::unique_ptr<std::string> text(new std::string("queued"));
+	std::string result;
+	queue.push([text = std::move(text), &result]() { result = *text; });
+	queue.push(Tracked(&calls));
+	assert(queue.size() == 2);
+	queue.start(false);
+	assert(result == "queued" && calls == 5 && alive == 0);
+
+	std::cout << "Done!\n";
+}
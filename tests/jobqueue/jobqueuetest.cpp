@@ -1,6 +1,9 @@
 #include "jobqueuetest.h"
 #include "data/jobqueue.h"
 #include <thread>
+#include <atomic>
+#include <vector>
+#include <string>
 #include <cassert>
 #include <iostream>
 
@@ -35,6 +38,70 @@ void test()
 	}
 }
 
+/*******************************************************
+ * testAsync                                           *
+ * Pushes jobs from several threads to a queue running *
+ * on its own thread, which sleeps between them        *
+ *******************************************************/
+void testAsync()
+{
+	JobQueue asyncJobs;
+	std::atomic<int> ran(0);
+	assert(asyncJobs.start());
+
+	// Push in bursts so that the queue goes to sleep in between
+	std::vector<std::thread> producers;
+	for (int i = 0; i < 4; ++i)
+		producers.push_back(std::thread([&]()
+		{
+			for (int j = 0; j < 1000; ++j)
+			{
+				asyncJobs.push([&]() { ran.fetch_add(1); });
+				if (j % 100 == 0)
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}));
+	for (size_t i = 0; i < producers.size(); ++i)
+		producers[i].join();
+
+	// Wait for the queue to catch up
+	for (int i = 0; i < 1000 && ran.load() < 4000; ++i)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	assert(ran.load() == 4000 && asyncJobs.empty());
+	std::cout << "Ran " << ran.load() << " jobs asynchronously...\n";
+}
+
+/*******************************************************
+ * testPriorities                                      *
+ * Checks that urgent jobs run first, that the lanes   *
+ * behind them still get a turn and that the deadline  *
+ * and lowest priority are kept to                     *
+ *******************************************************/
+void testPriorities()
+{
+	PriorityJobQueue lanes;
+	std::vector<char> order;
+	for (int i = 0; i < 40; ++i)
+		lanes.push([&]() { order.push_back('n'); });
+	for (int i = 0; i < 2; ++i)
+		lanes.push([&]() { order.push_back('b'); }, JobPriority::Bulk);
+	for (int i = 0; i < 3; ++i)
+		lanes.push([&]() { order.push_back('c'); }, JobPriority::Critical);
+	assert(lanes.size() == 45 && lanes.size(JobPriority::Critical) == 3);
+
+	// Without the bulk lane, it's left alone
+	assert(lanes.run(JobPriority::Critical) == 3);
+	assert(lanes.run(JobPriority::Normal, std::chrono::steady_clock::now()) == 1);
+	assert(lanes.size(JobPriority::Bulk) == 2);
+	assert(std::string(order.begin(), order.end()) == "cccn");
+
+	// The bulk lane gets a turn every so often even while the normal lane is busy
+	order.clear();
+	assert(lanes.run(JobPriority::Bulk) == 41 && lanes.empty());
+	assert(order[JOB_LANE_PATIENCE] == 'b' && order[JOB_LANE_PATIENCE * 2 + 1] == 'b');
+	std::cout << "Ran " << order.size() << " jobs in priority order...\n";
+}
+
 /***************************************************************
  * JOB QUEUE TEST                                              *
  ***************************************************************
@@ -59,5 +126,14 @@ void JobQueueTest() {
 
 	// Execute the rest of the jobs
 	std::cout << "Starting...\n";
-	std::cout << (jobs.start(false) ? "Finished...\n" : "Stopped...\n") << "Done!\n";
+	std::cout << (jobs.start(false) ? "Finished...\n" : "Stopped...\n");
+
+	// Run a queue on its own thread, which has to wake up for every burst of jobs
+	std::cout << "Starting asynchronously...\n";
+	testAsync();
+
+	// Run jobs from lanes of different priorities
+	std::cout << "Running priorities...\n";
+	testPriorities();
+	std::cout << "Done!\n";
 }
@@ -0,0 +1,120 @@
+#include "outboundqueuetest.h"
+#include "data/outboundqueue.h"
+#include <cassert>
+#include <iostream>
+
+/***************************************************************
+ * OUTBOUND QUEUE TEST                                         *
+ ***************************************************************
+ * Tests that small packets get packed together, big packets   *
+ * keep their own buffers, that partial writes pick up right   *
+ * where they left off, that pending packets hold up the       *
+ * packets behind them, and that packets sent to many clients  *
+ * are shared between their queues                             *
+ ***************************************************************/
+void OutboundQueueTest() {
+	OutboundQueue queue;
+	String written;
+
+	// Small packets should end up in one buffer
+	std::cout << "Packing small packets...\n";
+	queue.push("abc", 3);
+	queue.push(String("defg"));
+	assert(queue.size() == 7);
+	OutboundSlice slices[OUTBOUND_MAX_SLICES];
+	assert(queue.getSlices(slices, OUTBOUND_MAX_SLICES) == 1);
+	assert(String(slices[0].data, slices[0].length) == "abcdefg");
+
+	// Big packets get their own buffer
+	std::cout << "Queueing a big packet...\n";
+	String big(OUTBOUND_CHUNK_SIZE, 'x');
+	queue.push(std::move(big));
+	queue.push("hi", 2);
+	assert(queue.size() == 9 + OUTBOUND_CHUNK_SIZE);
+	assert(queue.getSlices(slices, OUTBOUND_MAX_SLICES) == 3);
+
+	// A writer that only takes five bytes at a time
+	std::cout << "Writing in pieces...\n";
+	while (!queue.empty())
+	{
+		Long wrote = queue.flush([&written](const OutboundSlice* slices, Int) -> Long
+		{
+			size_t length = slices[0].length < 5 ? slices[0].length : 5;
+			written.append(slices[0].data, length);
+			return (Long)length;
+		});
+		assert(wrote > 0);
+	}
+	assert(written == "abcdefg" + String(OUTBOUND_CHUNK_SIZE, 'x') + "hi");
+
+	// A writer that fails shouldn't lose anything
+	std::cout << "Failing to write...\n";
+	queue.push("oops", 4);
+	assert(queue.flush([](const OutboundSlice*, Int) -> Long { return -1; }) == -1);
+	assert(queue.size() == 4);
+
+	// Swapping hands over everything
+	OutboundQueue other;
+	queue.swap(other);
+	assert(queue.empty() && other.size() == 4);
+
+	// A pending packet holds up everything behind it until it's ready
+	std::cout << "Waiting on a pending packet...\n";
+	std::shared_ptr<OutboundPending> pending = other.pushPending(100);
+	other.push("after", 5);
+	assert(other.size() == 109);
+	assert(other.getSlices(slices, OUTBOUND_MAX_SLICES) == 1);
+	OutboundQueue ready;
+	other.moveReadyTo(ready);
+	assert(ready.size() == 4 && other.size() == 105);
+	assert(other.getSlices(slices, OUTBOUND_MAX_SLICES) == 0);
+
+	// Once it's ready, its real size replaces the guess
+	pending->data = std::make_shared<const String>("compressed");
+	pending->ready.store(true);
+	assert(other.getSlices(slices, OUTBOUND_MAX_SLICES) == 2);
+	assert(other.size() == 15);
+	other.moveReadyTo(ready);
+	written.clear();
+	ready.flush([&written](const OutboundSlice* slices, Int count) -> Long
+	{
+		Long total = 0;
+		for (Int i = 0; i < count; ++i)
+		{
+			written.append(slices[i].data, slices[i].length);
+			total += slices[i].length;
+		}
+		return total;
+	});
+	assert(written == "oopscompressedafter" && ready.empty() && other.empty());
+
+	// Big packets going to many clients are shared instead of copied, even once they're ready
+	std::cout << "Sharing a packet between queues...\n";
+	std::shared_ptr<const String> shared = std::make_shared<const String>(OUTBOUND_CHUNK_SIZE, 's');
+	std::shared_ptr<OutboundPending> sharedPending = std::make_shared<OutboundPending>();
+	OutboundQueue first, second;
+	first.push(shared);
+	second.push(shared);
+	first.pushPending(sharedPending, 50);
+	second.pushPending(sharedPending, 50);
+	assert(first.size() == OUTBOUND_CHUNK_SIZE + 50 && second.size() == OUTBOUND_CHUNK_SIZE + 50);
+	sharedPending->data = std::make_shared<const String>("deflated");
+	sharedPending->ready.store(true);
+	OutboundSlice slices2[OUTBOUND_MAX_SLICES];
+	assert(first.getSlices(slices, OUTBOUND_MAX_SLICES) == 2 && second.getSlices(slices2, OUTBOUND_MAX_SLICES) == 2);
+	assert(slices[0].data == shared->data() && slices2[0].data == shared->data());
+	assert(slices[1].data == sharedPending->data->data() && slices2[1].data == sharedPending->data->data());
+	first.consume(OUTBOUND_CHUNK_SIZE + 8);
+	assert(first.empty() && second.size() == OUTBOUND_CHUNK_SIZE + 8);
+
+	// A closed queue drops what it had and never takes or writes anything again
+	std::cout << "Closing...\n";
+	assert(second.close() && !second.close() && second.isClosed());
+	second.push("late", 4);
+	second.push(shared);
+	second.pushPending(100);
+	assert(second.empty());
+	assert(second.flush([](const OutboundSlice*, Int) -> Long { assert(false); return -1; }) == 0);
+
+	std::cout << "Done!\n";
+}
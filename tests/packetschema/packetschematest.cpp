@@ -0,0 +1,101 @@
+#include "packetschematest.h"
+#include "data/packetschema.h"
+#include <cassert>
+#include <iostream>
+
+enum class TestMode
+{
+	First = 0,
+	Second = 1
+};
+
+struct FixedArgs
+{
+	Short a;
+	Int b;
+	Double c;
+	Boolean d;
+	TestMode mode;
+};
+
+struct VariableArgs
+{
+	Int a;
+	String b;
+	Long c;
+	PositionF d;
+};
+
+typedef PacketSchema<FixedArgs,
+	Field<ShortCodec, &FixedArgs::a>,
+	Field<IntCodec, &FixedArgs::b>,
+	Field<DoubleCodec, &FixedArgs::c>,
+	Field<BooleanCodec, &FixedArgs::d>,
+	Field<ByteCodec, &FixedArgs::mode>> FixedSchema;
+
+typedef PacketSchema<VariableArgs,
+	Field<VarIntCodec, &VariableArgs::a>,
+	Field<StringCodec, &VariableArgs::b>,
+	Field<VarLongCodec, &VariableArgs::c>,
+	Field<PositionFCodec, &VariableArgs::d>> VariableSchema;
+
+static_assert(FixedSchema::fixed && FixedSchema::size == 16, "Fixed layouts should be bounds checked once");
+static_assert(!VariableSchema::fixed, "VarInts and Strings aren't a fixed size");
+static_assert(FixedSchema::minSize == 16 && FixedSchema::maxSize == 16, "Fixed layouts are only ever one length");
+static_assert(VariableSchema::minSize == 1 + 1 + 1 + 24 && VariableSchema::maxSize == 5 + 3 + SERIALSTRING_MAX_LENGTH * 4 + 10 + 24, "Variable layouts are bounded by their fields");
+
+/***************************************************************
+ * PACKETSCHEMA TEST                                           *
+ ***************************************************************
+ * Tests that packets written with a schema are read back the  *
+ * same, and that no schema reads past the end of a packet     *
+ * that's too short or holds a length that doesn't fit         *
+ ***************************************************************/
+void PacketSchemaTest() {
+	// Write and read back a packet with a fixed layout
+	std::cout << "Reading a fixed packet...\n";
+	FixedArgs fixed = { -2, 0x12345678, 3.5, true, TestMode::Second };
+	PacketWriter packet(0);
+	FixedSchema::write(packet, fixed);
+	String data(packet.getBody() + 1, packet.getBodySize() - 1);
+	assert(data.size() == (size_t)FixedSchema::size);
+	FixedArgs fixed2;
+	assert(FixedSchema::read((const Byte*)data.data(), (Int)data.size(), fixed2));
+	assert(fixed2.a == -2 && fixed2.b == 0x12345678 && fixed2.c == 3.5 && fixed2.d && fixed2.mode == TestMode::Second);
+
+	// Every byte has to be there
+	assert(!FixedSchema::read((const Byte*)data.data(), (Int)data.size() - 1, fixed2));
+
+	// Write and read back a packet with a variable layout
+	std::cout << "Reading a variable packet...\n";
+	VariableArgs variable = { -1, "hello", 1LL << 40, PositionF(1.5, -2, 64) };
+	PacketWriter packet2(0);
+	VariableSchema::write(packet2, variable);
+	data.assign(packet2.getBody() + 1, packet2.getBodySize() - 1);
+	VariableArgs variable2;
+	PacketReader reader((const Byte*)data.data(), (Int)data.size());
+	assert(VariableSchema::read(reader, variable2));
+	assert(reader.getRemaining() == 0);
+	assert((Int)data.size() >= VariableSchema::minSize && (Int)data.size() <= VariableSchema::maxSize);
+	assert(variable2.a == -1 && variable2.b == "hello" && variable2.c == 1LL << 40);
+	assert(variable2.d.x == 1.5 && variable2.d.y == -2 && variable2.d.z == 64);
+
+	// Cutting it short anywhere fails
+	for (Int i = 0; i < (Int)data.size(); i++)
+		assert(!VariableSchema::read((const Byte*)data.data(), i, variable2));
+
+	// A string can't say it's longer than the packet, or negative
+	std::cout << "Catching bad lengths...\n";
+	const Byte tooLong[] = { 0, 10, 'h', 'i' };
+	assert(!VariableSchema::read(tooLong, sizeof(tooLong), variable2));
+	const Byte negative[] = { 0, -1, -1, -1, -1, 0x0F, 'h', 'i' };
+	assert(!VariableSchema::read(negative, sizeof(negative), variable2));
+
+	// And a VarInt can't go on forever
+	const Byte endless[] = { -1, -1, -1, -1, -1, -1, 0 };
+	PacketReader reader2(endless, sizeof(endless));
+	reader2.readVarInt();
+	assert(reader2.hasFailed() && reader2.readByte() == 0);
+
+	std::cout << "Done!\n";
+}
@@ -0,0 +1,60 @@
+#include "packetwritertest.h"
+#include "data/packetwriter.h"
+#include <cassert>
+#include <iostream>
+
+/***************************************************************
+ * PACKETWRITER TEST                                           *
+ ***************************************************************
+ * Tests that packets come out in network order with the right *
+ * length in front, with and without compression, and that a   *
+ * packet that needs a longer length still comes out right     *
+ ***************************************************************/
+void PacketWriterTest() {
+	// Write one of every type
+	std::cout << "Writing a packet...\n";
+	PacketWriter packet(0x21);
+	packet.writeByte(-1);
+	packet.writeBoolean(true);
+	packet.writeShort(0x0102);
+	packet.writeInt(0x03040506);
+	packet.writeLong(0x0708090A0B0C0D0ELL);
+	packet.writeFloat(1.0f);
+	packet.writeDouble(-2.0);
+	packet.writeVarInt(300);
+	packet.writeVarLong(-1);
+	packet.writeString("hi");
+	const char expected[] = "\x21\xFF\x01\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0A\x0B\x0C\x0D\x0E"
+		"\x3F\x80\x00\x00\xC0\x00\x00\x00\x00\x00\x00\x00\xAC\x02"
+		"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x01\x02hi";
+	Int size = sizeof(expected) - 1;
+	assert(packet.getBodySize() == size);
+	assert(String(packet.getBody(), size) == String(expected, size));
+
+	// The length goes right in front of the body
+	packet.finish();
+	assert(packet.getSize() == (size_t)size + 1);
+	assert(packet.getData()[0] == size);
+	assert(String(packet.getData() + 1, size) == String(expected, size));
+
+	// With compression on there's an uncompressed length of zero between them
+	std::cout << "Finishing with compression...\n";
+	packet.finish(true);
+	assert(packet.getSize() == (size_t)size + 2);
+	assert(packet.getData()[0] == size + 1 && packet.getData()[1] == 0);
+
+	// Long packets need more than one byte for their length
+	std::cout << "Writing a long packet...\n";
+	PacketWriter big(0x22);
+	String data(70000, 'x');
+	big.writeBytes(data.data(), data.size());
+	big.finish(true);
+	char length[5];
+	Int lengthSize = PacketWriter::encodeVarInt(length, 70002);
+	assert(lengthSize == 3);
+	assert(big.getSize() == 70002 + (size_t)lengthSize);
+	assert(String(big.getData(), lengthSize) == String(length, lengthSize));
+	assert(big.getData()[lengthSize] == 0 && big.getData()[lengthSize + 1] == 0x22);
+
+	std::cout << "Done!\n";
+}
@@ -0,0 +1,60 @@
+#include "ringbuffertest.h"
+#include "data/ringbuffer.h"
+#include <cassert>
+#include <iostream>
+
+/***************************************************************
+ * RING BUFFER TEST                                            *
+ ***************************************************************
+ * Tests that bytes come out of the ring buffer in the order   *
+ * they went in, even when they wrap around its end or make it *
+ * grow, and that peeking hands back the bytes in one piece    *
+ ***************************************************************/
+void RingBufferTest() {
+	RingBuffer ring(16);
+	Byte data[64];
+	for (int i = 0; i < 64; ++i)
+		data[i] = (Byte)i;
+
+	// Fill most of the buffer, then drop some to move the front
+	std::cout << "Appending and consuming...\n";
+	ring.append(data, 12);
+	assert(ring.size() == 12 && ring.getCapacity() == 16);
+	ring.consume(10);
+	assert(ring.size() == 2 && ring[0] == 10 && ring[1] == 11);
+
+	// Append enough to wrap around the end without growing
+	ring.append(data + 12, 10);
+	assert(ring.getCapacity() == 16);
+	for (int i = 0; i < ring.size(); ++i)
+		assert(ring[i] == 10 + i);
+
+	// Peeking at bytes that wrap around should straighten them out
+	std::cout << "Peeking...\n";
+	Byte* view = ring.peek(12);
+	for (int i = 0; i < 12; ++i)
+		assert(view[i] == 10 + i);
+	ring.consume(12);
+	assert(ring.empty());
+
+	// Growing should keep the bytes in order
+	std::cout << "Growing...\n";
+	ring.append(data, 5);
+	ring.consume(3);
+	ring.append(data + 5, 59);
+	assert(ring.size() == 61 && ring.getCapacity() == 64);
+	for (int i = 0; i < ring.size(); ++i)
+		assert(ring[i] == 3 + i);
+
+	// Consuming more than is left (say after the buffer was cleared and freed) only empties it
+	std::cout << "Consuming past the end...\n";
+	RingBuffer big(RINGBUFFER_MAX_IDLE_CAPACITY * 2);
+	big.append(data, 64);
+	big.clear();
+	big.consume(64);
+	assert(big.empty() && big.getCapacity() == 0);
+	big.append(data, 64);
+	assert(big.size() == 64 && big[63] == 63);
+
+	std::cout << "Done!\n";
+}
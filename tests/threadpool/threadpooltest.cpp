@@ -0,0 +1,86 @@
+#include "threadpooltest.h"
+#include "data/threadpool.h"
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+/*******************************************************
+ * fibonacci                                           *
+ * Forks off half of the work at every level and       *
+ * waits on it, to test tasks that wait on tasks       *
+ *******************************************************/
+Long fibonacci(ThreadPool& pool, Int n)
+{
+	if (n < 12)
+		return n < 2 ? n : fibonacci(pool, n - 1) + fibonacci(pool, n - 2);
+
+	Long a = 0;
+	TaskGroup group;
+	pool.run(group, [&pool, &a, n]() { a = fibonacci(pool, n - 1); });
+	Long b = fibonacci(pool, n - 2);
+	pool.wait(group);
+	return a + b;
+}
+
+/***************************************************************
+ * THREAD POOL TEST                                            *
+ ***************************************************************
+ * Tests that the pool runs every task it's given exactly      *
+ * once, whether they come from outside of the pool, from      *
+ * parallelFor, or from tasks forking more tasks and waiting   *
+ * on them (which only works if waiting runs other tasks)      *
+ ***************************************************************/
+void ThreadPoolTest() {
+	ThreadPool pool(4);
+
+	// Tasks from outside of the pool
+	std::cout << "Running groups...\n";
+	std::atomic<Int> ran(0);
+	TaskGroup group;
+	for (Int i = 0; i < 1000; ++i)
+		pool.run(group, [&ran]() { ran.fetch_add(1); });
+	pool.wait(group);
+	assert(ran.load() == 1000 && group.done());
+
+	// Every index exactly once, with and without a grain
+	std::cout << "Running parallelFor...\n";
+	std::vector<Int> hits(10007, 0);
+	pool.parallelFor(0, hits.size(), [&hits](size_t i) { hits[i]++; });
+	pool.parallelFor(0, hits.size(), [&hits](size_t i) { hits[i]++; }, 100);
+	for (size_t i = 0; i < hits.size(); ++i)
+		assert(hits[i] == 2);
+	pool.parallelFor(5, 5, [](size_t) { assert(false); });
+
+	// Fork and join
+	std::cout << "Forking and joining...\n";
+	assert(fibonacci(pool, 25) == 75025);
+
+	// Waiting from outside of the pool only helps with the group's own tasks
+	std::cout << "Waiting from outside...\n";
+	{
+		ThreadPool single(1);
+		std::atomic<Boolean> release(false);
+		std::atomic<Boolean> started(false);
+		std::atomic<Boolean> otherRan(false);
+		single.push([&release, &started]() { started.store(true); while (!release.load()) std::this_thread::yield(); });
+		while (!started.load())
+			std::this_thread::yield();
+		std::thread::id self = std::this_thread::get_id();
+		single.push([&otherRan, self]() { assert(std::this_thread::get_id() != self); otherRan.store(true); });
+		TaskGroup own;
+		Int ownRan = 0;
+		single.run(own, [&ownRan]() { ownRan++; });
+		single.wait(own);
+		assert(ownRan == 1 && !otherRan.load());
+		release.store(true);
+		while (!otherRan.load())
+			std::this_thread::yield();
+	}
+
+	// A pool going away with nothing to do
+	{
+		ThreadPool idle(2);
+	}
+
+	std::cout << "Done!\n";
+}
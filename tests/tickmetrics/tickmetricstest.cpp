@@ -0,0 +1,48 @@
+#include "tickmetricstest.h"
+#include "server/tickmetrics.h"
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+/***************************************************************
+ * TICK METRICS TEST                                           *
+ ***************************************************************
+ * Tests that the averages, the tick rate and the histogram    *
+ * only cover the latest ticks, that the percentiles come out  *
+ * of the right buckets and that skipped ticks are counted     *
+ ***************************************************************/
+void TickMetricsTest() {
+	TickMetrics metrics;
+	assert(metrics.getMSPT() == 0.0 && metrics.getTPS() == 0.0 && metrics.getPercentile(0.5) == 0.0);
+
+	// A steady 20 TPS, with one slow tick
+	std::cout << "Recording ticks...\n";
+	for (int i = 0; i < TICK_METRICS_WINDOW; ++i)
+		metrics.record(i * 0.05, i == 10 ? 200.0 : 10.5);
+	assert(std::fabs(metrics.getTPS() - 20.0) < 1e-9);
+	assert(std::fabs(metrics.getMSPT() - (10.5 * (TICK_METRICS_WINDOW - 1) + 200.0) / TICK_METRICS_WINDOW) < 1e-9);
+	assert(metrics.getPercentile(0.5) == 11.0);
+	assert(metrics.getPercentile(1.0) == 200.0 && metrics.getPeakMSPT() == 200.0);
+
+	std::vector<Long> histogram;
+	metrics.getHistogram(histogram);
+	assert(histogram.size() == TICK_HISTOGRAM_BUCKETS);
+	assert(histogram[10] == TICK_METRICS_WINDOW - 1 && histogram[TICK_HISTOGRAM_BUCKETS - 1] == 1);
+
+	// Slower ticks push the old ones out of the window
+	std::cout << "Rolling the window over...\n";
+	for (int i = 0; i < TICK_METRICS_WINDOW; ++i)
+		metrics.record(5.0 + i * 0.1, 40.0, i == 0 ? 3 : 0);
+	assert(std::fabs(metrics.getTPS() - 10.0) < 1e-9);
+	assert(std::fabs(metrics.getMSPT() - 40.0) < 1e-9);
+	assert(metrics.getPercentile(0.99) == 41.0);
+	metrics.getHistogram(histogram);
+	assert(histogram[10] == 0 && histogram[40] == TICK_METRICS_WINDOW);
+	assert(metrics.getTickCount() == 2 * TICK_METRICS_WINDOW && metrics.getSkippedTicks() == 3);
+
+	metrics.reset();
+	assert(metrics.getTickCount() == 0 && metrics.getMSPT() == 0.0);
+
+	std::cout << "Done!\n";
+}
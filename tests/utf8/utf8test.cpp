@@ -0,0 +1,63 @@
+#include "utf8test.h"
+#include "data/utf8.h"
+#include "data/packetreader.h"
+#include <cassert>
+#include <iostream>
+
+/*******************************************************
+ * count                                               *
+ * Validates a string, returning its character count   *
+ *******************************************************/
+Int count(const String& text)
+{
+	return validateUtf8((const Byte*)text.data(), text.size());
+}
+
+/***************************************************************
+ * UTF-8 TEST                                                  *
+ ***************************************************************
+ * Tests that well-formed UTF-8 is counted the way Minecraft   *
+ * counts it both in and out of the 16 byte blocks, that       *
+ * malformed UTF-8 is caught, and that strings are read out of *
+ * packets without going past their limits                     *
+ ***************************************************************/
+void Utf8Test() {
+	// ASCII, in whole blocks and not
+	std::cout << "Counting characters...\n";
+	assert(count("") == 0);
+	assert(count("Hello") == 5);
+	assert(count(String(100, 'a')) == 100);
+
+	// 2, 3 and 4 byte characters, with the 4 byte ones counting twice
+	String mixed = String(15, 'a') + "\xC3\xA9" + String(20, 'b') + "\xE2\x82\xAC" + "\xF0\x9F\x98\x80" + "c";
+	assert(count(mixed) == 15 + 1 + 20 + 1 + 2 + 1);
+
+	// Malformed characters anywhere in the string
+	std::cout << "Catching malformed UTF-8...\n";
+	const char* bad[] = { "\x80", "\xC0\xAF", "\xC3", "\xE0\x80\x80", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\xF5\x80\x80\x80", "\xE2\x82" };
+	for (const char* b : bad)
+	{
+		assert(count(b) == -1);
+		assert(count(String(30, 'a') + b) == -1);
+		assert(count(String(14, 'a') + b + String(20, 'a')) == -1);
+	}
+
+	// Strings read out of a packet point into it
+	std::cout << "Reading strings...\n";
+	PacketWriter packet(0);
+	packet.writeString(mixed);
+	packet.writeString("abcdef");
+	packet.writeString("\xFF");
+	PacketReader reader((const Byte*)packet.getBody() + 1, packet.getBodySize() - 1);
+	StringView view = reader.readStringView();
+	assert(view == mixed && view.data() == packet.getBody() + 2);
+	assert(reader.readString(6) == "abcdef");
+	assert(reader.readStringView().empty() && reader.hasFailed());
+
+	// Too many characters
+	PacketReader longReader((const Byte*)packet.getBody() + 1, packet.getBodySize() - 1);
+	longReader.readStringView(10);
+	assert(longReader.hasFailed());
+
+	std::cout << "Done!\n";
+}
@@ -0,0 +1,77 @@
+#include "varintbatchtest.h"
+#include "data/varintbatch.h"
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+/*******************************************************
+ * roundTrip                                           *
+ * Encodes the values in bulk, checks that it matches  *
+ * encoding them one by one, and decodes them back     *
+ *******************************************************/
+void roundTrip(const std::vector<Int>& values)
+{
+	std::vector<Byte> encoded(values.size() * VARINT_MAX_SIZE + 1);
+	size_t size = encodeVarInts(values.data(), values.size(), encoded.data());
+
+	std::vector<Byte> expected;
+	for (Int value : values)
+	{
+		VarInt v = VarInt(value);
+		expected.insert(expected.end(), v.getData(), v.getData() + v.getSize());
+	}
+	assert(size == expected.size() && std::equal(expected.begin(), expected.end(), encoded.begin()));
+
+	std::vector<Int> decoded(values.size());
+	assert(decodeVarInts(encoded.data(), size, decoded.data(), values.size()) == (Long)size);
+	assert(decoded == values);
+
+	// Running out of data anywhere fails
+	if (size > 0)
+		assert(decodeVarInts(encoded.data(), size - 1, decoded.data(), values.size()) == -1);
+}
+
+/***************************************************************
+ * VARINT BATCH TEST                                           *
+ ***************************************************************
+ * Tests that the bulk VarInt encoder and decoder give the     *
+ * same bytes and numbers as VarInt does, for runs of small    *
+ * numbers that take the fast paths and for mixed sizes that   *
+ * don't, and that overlong VarInts are caught                 *
+ ***************************************************************/
+void VarIntBatchTest() {
+	// Runs of one and two byte numbers
+	std::cout << "Encoding runs of small numbers...\n";
+	std::vector<Int> values;
+	for (Int i = 0; i < 100; ++i)
+		values.push_back(i);
+	roundTrip(values);
+	values.clear();
+	for (Int i = 0; i < 100; ++i)
+		values.push_back(128 + i * 150);
+	roundTrip(values);
+
+	// Every size mixed together
+	std::cout << "Encoding mixed numbers...\n";
+	values.clear();
+	UInt seed = 12345;
+	for (Int i = 0; i < 1000; ++i)
+	{
+		seed = seed * 1103515245 + 12345;
+		values.push_back((Int)(seed >> (seed % 32)) * ((i % 7) == 0 ? -1 : 1));
+	}
+	roundTrip(values);
+	values.assign(3, 0);
+	roundTrip(values);
+
+	// A VarInt can't go past 5 bytes, in or out of the fast paths
+	std::cout << "Catching overlong VarInts...\n";
+	std::vector<Byte> bad(32, 0);
+	for (Int i = 0; i < 6; ++i)
+		bad[i] = (Byte)0x80;
+	Int out[32];
+	assert(decodeVarInts(bad.data(), bad.size(), out, 20) == -1);
+	assert(decodeVarInts(bad.data(), 8, out, 1) == -1);
+
+	std::cout << "Done!\n";
+}
@@ -4,6 +4,7 @@
 #include <thread>
 #include <chrono>
 #include <climits>
+#include <stdexcept>
 #include <iostream>
 
 // Global Variables
@@ -55,10 +56,34 @@ void GuiThread()
 /*************************************************************
  * VAR NUM TEST                                              *
  *************************************************************
- * Tests that all VarNums are correct and do not leak memory *
+ * Tests that all VarNums are correct and the right size     *
  * Note: this is a very long test, will take WEEKS to finish!*
  *************************************************************/
 void VarNumTest() {
+	// The size worked out from the highest bit should match the size that gets written
+	std::cout << "Checking sizes...\n";
+	for (Int bit = 0; bit < 64; ++bit)
+	{
+		Long value = (Long)(1ULL << bit);
+		Int expected = 1;
+		for (ULong rest = (ULong)value >> 7; rest != 0; rest >>= 7)
+			++expected;
+		if (VarLong::sizeOf(value) != expected || VarLong(value).getSize() != expected)
+			std::cout << "VarLong " << value << " should take " << expected << " bytes! (assert failed)\n";
+		if (bit < 32 && (VarInt::sizeOf((Int)value) != expected || VarInt((Int)value).getSize() != expected))
+			std::cout << "VarInt " << value << " should take " << expected << " bytes! (assert failed)\n";
+	}
+	if (VarInt::sizeOf(0) != 1 || VarInt::sizeOf(-1) != VARINT_MAX_SIZE || VarLong::sizeOf(-1) != VARLONG_MAX_SIZE)
+		std::cout << "Zero and negative numbers are the wrong size! (assert failed)\n";
+
+	// Reading a VarInt that doesn't end in time throws
+	const Byte tooLong[] = { -1, -1, -1, -1, -1, 0 };
+	Boolean threw = false;
+	try { (void)VarInt(tooLong); }
+	catch (const std::overflow_error&) { threw = true; }
+	if (!threw)
+		std::cout << "A 6 byte VarInt was read! (assert failed)\n";
+
 	// Start the GUI Thread
 	std::thread gui(GuiThread);
 